@@ -1,76 +1,420 @@
 #include "AI.h"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cassert>
 #include <chrono>
+#include <climits>
+#include <cmath>
 #include <condition_variable>
 #include <cstdlib>
 #include <iostream>
 #include <mutex>
-#include <unordered_map>
-#include <utility>
-#include <vector>
+#include <string>
+#include <thread>
 
 #include "../Chess/ChessBoard.h"
+#include "../Chess/MoveGen.h"
+#include "../Utils/Allocations.h"
 #include "../Utils/bits.h"
+#include "MovePicker.h"
 #include "PieceSqTable.h"
+#include "See.h"
+
+namespace {
+
+// Late move reductions by depth left and move number, growing with the log of both
+const auto LMR_TABLE = [] {
+    std::array<std::array<int8_t, 64>, 64> table{};
+    for (int depth = 1; depth < 64; ++depth) {
+        for (int moveNumber = 1; moveNumber < 64; ++moveNumber) {
+            table[depth][moveNumber] = static_cast<int8_t>(0.75 + std::log(depth) * std::log(moveNumber) / 2.25);
+        }
+    }
+    return table;
+}();
+
+// A move with a good history is reduced less, one with a bad history more, and always to at least depth 1
+int lateMoveReduction(int depth, int moveNumber, int history) {
+    int reduction = LMR_TABLE[std::min(depth, 63)][std::min(moveNumber, 63)];
+    reduction -= history / (HistoryTables::MAX_HISTORY / 2);
+    return std::clamp(reduction, 0, depth - 2);
+}
+
+// With only pawns left, passing is often the best move, and the null move observation fails
+bool hasNonPawnMaterial(const Position& position) {
+    bool isWhite = position.isWhiteToMove();
+    uint64_t pawnsAndKing = position.getPieceBitboard(PAWN, isWhite) | position.getPieceBitboard(KING, isWhite);
+    return (position.getColorBitboard(isWhite) & ~pawnsAndKing) != 0;
+}
+
+}  // namespace
+
+SearchMode searchModeFromString(const std::string& name) {
+    if (name == "root") return ROOT_SPLIT;
+    if (name == "ybwc") return YBWC;
+    return LAZY_SMP;
+}
+
+const char* searchModeToString(SearchMode mode) {
+    switch (mode) {
+        case ROOT_SPLIT:
+            return "root";
+        case YBWC:
+            return "ybwc";
+        default:
+            return "lazy_smp";
+    }
+}
+
+AI::AI(int maxDepth, int timeLimit, int hashSize, int threads, SearchMode mode)
+    : maxDepth(maxDepth),
+      timeLimit(timeLimit),
+      threads(threads > 0 ? threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))),
+      mode(mode),
+      transpositionTable(hashSize),
+      threadpool(this->threads) {
+    for (int i = 0; i < this->threads; ++i) {
+        threadData.push_back(std::make_unique<ThreadData>());
+        threadData.back()->isHelper = i > 0;
+    }
+}
 
 void AI::makeMove(ChessBoard* board, bool isWhite) {
-    startTime = std::chrono::steady_clock::now();
-    searchRootIsWhite = isWhite;
+    auto moveStartTime = std::chrono::steady_clock::now();
 
     ChessBoard boardCopy;
     {
         std::lock_guard<std::mutex> lock(board->mtx);
-        boardCopy = std::move(board->clone());
+        boardCopy = board->clone();
     }
 
-    Move bestMove = findBestMove(&boardCopy, isWhite);
+    // The search of this position may have started on the opponent's time
+    Move bestMove = finishPondering(boardCopy.getPosition());
+
+    if (MoveList(boardCopy.getPosition()).empty()) {
+        std::cout << (boardCopy.getPosition().isInCheck() ? "Checkmate" : "Stalemate") << std::endl;
+        return;
+    }
+
+    // Known openings come from the book, leaving nothing to ponder on
+    if (bestMove == Move::none()) {
+        bestMove = book.probe(boardCopy.getPosition());
+        if (bestMove != Move::none()) {
+            std::cout << "Book move " << moveToString(bestMove) << std::endl;
+            principalVariation.clear();
+        }
+    }
+
+    if (bestMove == Move::none()) bestMove = findBestMove(&boardCopy, isWhite);
 
     board->mtx.lock();
-    if (!board->movePiece(bestMove.fromX, bestMove.fromY, bestMove.toX, bestMove.toY)) {
+    if (!board->movePiece(bestMove)) {
         std::cout << "AI move failed, this should not happen" << std::endl;
     }
     board->mtx.unlock();
 
     auto endTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - moveStartTime);
     std::cout << "Time to find best move " << duration.count() << " milliseconds\n";
+
+    // Think on the opponent's time about the reply the principal variation expects
+    if (ponder && principalVariation.size() >= 2) {
+        Position ponderRoot = boardCopy.getPosition();
+        if (ponderRoot.movePiece(bestMove) && ponderRoot.movePiece(principalVariation[1])) startPondering(ponderRoot);
+    }
+}
+
+Move AI::findBestMove(const ChessBoard* const board, [[maybe_unused]] bool isWhite) {
+    assert(board->getPosition().isWhiteToMove() == isWhite);
+    searchControl.start(timeLimit);
+    return iterativeDeepening(board->getPosition());
+}
+
+void AI::startPondering(const Position& root) {
+    ponderHash = root.getHash();
+    searchControl.start(timeLimit, true);
+    ponderThread = std::thread([this, root]() { ponderMove = iterativeDeepening(root); });
+}
+
+// A search of the position now on the board goes on against the clock, any other is cancelled. Either way its
+// results stay in the table.
+Move AI::finishPondering(const Position& position) {
+    if (!ponderThread.joinable()) return Move::none();
+
+    bool hit = position.getHash() == ponderHash;
+    if (hit) {
+        std::cout << "Ponder hit" << std::endl;
+        searchControl.ponderHit();
+    } else {
+        searchControl.stop();
+    }
+
+    ponderThread.join();
+    return hit ? ponderMove : Move::none();
 }
 
-Move AI::findBestMove(const ChessBoard* const board, bool isWhite) {
-    float bestScore = -10000.0f;
-    Move bestMove{};
+Move AI::iterativeDeepening(const Position& root) {
+    transpositionTable.newSearch();
+    principalVariation.clear();
 
-    auto moves = generateMoves(board, isWhite);
+    // The opponent answered as the last search expected, what it learned about this line still holds
+    const bool followsLine = root.getHash() == expectedRootHash;
+    if (followsLine) seedExpectedLine(root);
+    expectedRootHash = 0;
 
-    std::cout << "Cache hit count: " << cacheHitCount << std::endl;
-    std::cout << "Moves evaluated: " << evaluatedMoves << std::endl;
+    MoveList moves(root);
+
+    // A pondering search keeps quiet, the opponent is still thinking
+    if (!searchControl.isPondering()) std::cout << "Moves evaluated: " << evaluatedMoves << std::endl;
     evaluatedMoves = 0;
-    cacheHitCount = 0;
+    searchAllocations = 0;
+
+    if (moves.empty()) return Move::none();
+
+    // Nothing to search when the tablebases know the way
+    Move bestMove = tablebaseMove(root);
+    if (bestMove != Move::none()) {
+        if (!searchControl.isPondering()) std::cout << "Tablebase move " << moveToString(bestMove) << std::endl;
+        principalVariation.assign(1, bestMove);
+        return bestMove;
+    }
+
+    RootMove rootMoves[MAX_MOVES];
+    int moveCount = 0;
+    for (Move move : moves) rootMoves[moveCount++].move = move;
 
-    if (moves.empty()) return bestMove;
+    // The hash move from an earlier search goes first, it is the likeliest to be best
+    TTData rootEntry;
+    if (transpositionTable.probe(root.getHash(), rootEntry)) {
+        auto isHashMove = [&](const RootMove& rootMove) { return rootMove.move == rootEntry.move; };
+        RootMove* hashMove = std::find_if(rootMoves, rootMoves + moveCount, isHashMove);
+        if (hashMove != rootMoves + moveCount) std::rotate(rootMoves, hashMove, hashMove + 1);
+    }
+
+    // Something to play even if the first iteration does not finish
+    bestMove = rootMoves[0].move;
+    float bestScore = 0.0f;
+
+    for (auto& thread : threadData) thread->newSearch(followsLine);
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        // Aspiration window: the score rarely moves far between iterations, and a narrow window prunes harder. A
+        // score outside it is only a bound, the window widens on that side and the iteration is searched again.
+        float alpha = -1e9f;
+        float beta = 1e9f;
+        float delta = ASPIRATION_WINDOW;
+        if (depth >= ASPIRATION_MIN_DEPTH && !isDecisive(bestScore)) {
+            alpha = bestScore - delta;
+            beta = bestScore + delta;
+        }
 
-    std::mutex mutex;
-    std::atomic<int> remainingTasks(moves.size());
+        while (true) {
+            float score = searchRoot(root, rootMoves, moveCount, depth, alpha, beta);
+            if (searchControl.isStopped()) break;
+
+            delta *= 2.0f;
+            if (score <= alpha) {
+                alpha = delta > ASPIRATION_MAX_WINDOW ? -1e9f : score - delta;
+            } else if (score >= beta) {
+                beta = delta > ASPIRATION_MAX_WINDOW ? 1e9f : score + delta;
+            } else {
+                break;
+            }
+        }
+
+        // A cut iteration has scores from a half-searched tree, keep the last complete one
+        if (searchControl.isStopped()) break;
+
+        // Best first, the next iteration searches the moves in this order. Insertion sort is stable and needs no
+        // temporary buffer, there are only a few dozen root moves.
+        for (int i = 1; i < moveCount; ++i) {
+            for (int j = i; j > 0 && rootMoves[j].score > rootMoves[j - 1].score; --j) {
+                std::swap(rootMoves[j], rootMoves[j - 1]);
+            }
+        }
+
+        bestMove = rootMoves[0].move;
+        bestScore = rootMoves[0].score;
+        principalVariation.assign(rootMoves[0].pv, rootMoves[0].pv + rootMoves[0].pvLength);
+        completedDepth = depth;
+
+        // The score landed inside the window, so it is exact
+        transpositionTable.store(root.getHash(), bestMove, scoreToTT(bestScore, 0), depth, BOUND_EXACT);
+
+        if (!searchControl.isPondering()) {
+            std::cout << "Depth " << depth << " score " << bestScore << " pv";
+            for (Move move : principalVariation) std::cout << ' ' << moveToString(move);
+            std::cout << std::endl;
+        }
+
+        // A found mate will not get better, and the next iteration would rarely finish in the time left
+        if (std::abs(bestScore) >= MATE_SCORE - MAX_PLY) break;
+        if (!searchControl.isPondering() && searchControl.getElapsed() > timeLimit / 2) break;
+    }
+
+    if (!searchControl.isPondering()) std::cout << "Best score: " << bestScore << std::endl;
+
+    // Two plies on, the next search starts where this one expects the game to be
+    Position expected = root;
+    if (principalVariation.size() > 2 && expected.movePiece(principalVariation[0]) &&
+        expected.movePiece(principalVariation[1])) {
+        expectedRootHash = expected.getHash();
+        expectedLine.assign(principalVariation.begin() + 2, principalVariation.end());
+    }
+
+    return bestMove;
+}
+
+// The move that mates soonest, or when lost holds out longest, Move::none() unless every move leads into the tables
+Move AI::tablebaseMove(const Position& root) const {
+    TablebaseWdl wdl;
+    if (popcount(root.getOccupied()) > tablebases.getMaxMen() || !tablebases.probe(root, wdl)) return Move::none();
+
+    Move bestMove = Move::none();
+    int bestRank = INT_MIN;
+    for (Move move : MoveList(root)) {
+        Position child = root;
+        UndoState undo;
+        child.makeMove(move, undo);
+
+        int plies = 0;
+        if (!tablebases.probe(child, wdl, &plies)) return Move::none();
+
+        // The result is the opponent's, a loss for it is a win here
+        int rank = wdl == TB_LOSS ? 1000 - plies : wdl == TB_WIN ? plies - 1000 : 0;
+        if (rank > bestRank) {
+            bestRank = rank;
+            bestMove = move;
+        }
+    }
+    return bestMove;
+}
+
+// Writes the rest of the expected line back as hash moves, where its entries were overwritten since. At depth 0
+// they order moves but never cut off a search.
+void AI::seedExpectedLine(const Position& root) {
+    Position position = root;
+    for (Move move : expectedLine) {
+        TTData entry;
+        if (!transpositionTable.probe(position.getHash(), entry) || entry.move == Move::none()) {
+            transpositionTable.store(position.getHash(), move, 0, 0, BOUND_UPPER);
+        }
+        if (!position.movePiece(move)) break;
+    }
+}
+
+float AI::searchRoot(const Position& root, RootMove* rootMoves, int moveCount, int depth, float alpha, float beta) {
+    if (mode == ROOT_SPLIT) return searchRootSplit(root, rootMoves, moveCount, depth, alpha, beta);
+
+    if (mode == LAZY_SMP) {
+        helpersStop = false;
+        for (int i = 1; i < threads; ++i) {
+            threadpool.submit([&, i, depth, alpha, beta]() {
+                ThreadData& thread = *threadData[i];
+                ChessBoard board(root);
+
+                // Only the moves are read, the main thread is writing the scores
+                RootMove helperMoves[MAX_MOVES];
+                for (int j = 0; j < moveCount; ++j) helperMoves[j].move = rootMoves[j].move;
+
+                // Half the helpers search one ply deeper, so they do not walk the tree in step with the main thread
+                searchRootMoves(board, thread, helperMoves, moveCount, depth + (i & 1), alpha, beta);
+            });
+        }
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(splitMutex);
+            iterationDone = false;
+        }
+        for (int i = 1; i < threads; ++i) threadpool.submit([this, i]() { helperLoop(*threadData[i]); });
+    }
+
+    // The search runs on stack move lists and the board's undo stack, it must not touch the heap
+    ChessBoard board(root);
+    uint64_t allocationsBefore = threadAllocationCount();
+    float score = searchRootMoves(board, *threadData[0], rootMoves, moveCount, depth, alpha, beta);
+    searchAllocations += threadAllocationCount() - allocationsBefore;
+
+    if (mode == LAZY_SMP) {
+        helpersStop = true;
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(splitMutex);
+            iterationDone = true;
+        }
+        splitCv.notify_all();
+    }
+
+    threadpool.join();
+    return score;
+}
+
+// One thread through the root moves, the first with the full window and the rest with a null window at alpha
+float AI::searchRootMoves(ChessBoard& board, ThreadData& thread, RootMove* rootMoves, int moveCount, int depth,
+                          float alpha, float beta) {
+    float bestScore = -1e9f;
+
+    for (int i = 0; i < moveCount; ++i) {
+        RootMove& rootMove = rootMoves[i];
+        searchControl.checkTime();
+
+        board.makeMove(rootMove.move);
+        float score;
+        if (i == 0) {
+            score = -negamax(board, thread, depth - 1, 1, -beta, -alpha);
+        } else {
+            score = -negamax(board, thread, depth - 1, 1, -alpha - 1.0f, -alpha);
+            if (score > alpha && score < beta && !isAborted(thread)) {
+                score = -negamax(board, thread, depth - 1, 1, -beta, -alpha);
+            }
+        }
+        board.unmakeMove();
+
+        if (isAborted(thread)) return bestScore;
+
+        // Moves that fail low keep their bound, enough to sort them behind the best one
+        rootMove.score = score;
+        bestScore = std::max(bestScore, score);
+        if (score > alpha) {
+            alpha = score;
+            rootMove.pv[0] = rootMove.move;
+            std::copy(thread.pv[1], thread.pv[1] + thread.pvLength[1], rootMove.pv + 1);
+            rootMove.pvLength = thread.pvLength[1] + 1;
+        }
+
+        // Failed high, the window is widened and every move searched again
+        if (score >= beta) break;
+    }
+
+    return bestScore;
+}
+
+float AI::searchRootSplit(const Position& root, RootMove* rootMoves, int moveCount, int depth, float alpha,
+                          float beta) {
+    std::atomic<int> remainingTasks(moveCount);
     std::condition_variable cv;
     std::mutex cvMutex;
 
-    for (const auto& move : moves) {
-        threadpool.submit([&, move]() {
-            ChessBoard newBoard = board->clone();
+    for (int i = 0; i < moveCount; ++i) {
+        RootMove& rootMove = rootMoves[i];
+        threadpool.submit([&, depth, alpha, beta]() {
+            ChessBoard searchBoard(root);
+            searchBoard.makeMove(rootMove.move);
+            ThreadData thread;
 
-            newBoard.movePiece(move.fromX, move.fromY, move.toX, move.toY);
+            // Root subtrees can be smaller than the polling interval
+            searchControl.checkTime();
 
-            bool nextIsWhite = !isWhite;
-            float score = minimax(&newBoard, maxDepth - 1, -1e9f, 1e9f, nextIsWhite);
+            // The search runs on stack move lists and the board's undo stack, it must not touch the heap
+            uint64_t allocationsBefore = threadAllocationCount();
+            rootMove.score = -negamax(searchBoard, thread, depth - 1, 1, -beta, -alpha);
+            searchAllocations += threadAllocationCount() - allocationsBefore;
 
-            {
-                std::lock_guard<std::mutex> lock(mutex);
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestMove = move;
-                }
-            }
+            rootMove.pv[0] = rootMove.move;
+            std::copy(thread.pv[1], thread.pv[1] + thread.pvLength[1], rootMove.pv + 1);
+            rootMove.pvLength = thread.pvLength[1] + 1;
 
             if (--remainingTasks == 0) {
                 std::lock_guard<std::mutex> lock(cvMutex);
@@ -86,178 +430,358 @@ Move AI::findBestMove(const ChessBoard* const board, bool isWhite) {
 
     threadpool.join();
 
-    std::cout << "Best score: " << bestScore << std::endl;
-
-    return bestMove;
+    float bestScore = -1e9f;
+    for (int i = 0; i < moveCount; ++i) bestScore = std::max(bestScore, rootMoves[i].score);
+    return bestScore;
 }
 
-std::vector<Move> AI::generateMoves(const ChessBoard* const board, bool isWhite) {
-    uint64_t boardHash = board->getBoardHash(isWhite);
+// Principal variation search, negamax with scores for the side to move
+float AI::negamax(ChessBoard& board, ThreadData& thread, int depth, int ply, float alpha, float beta) {
+    const Position& position = board.getPosition();
+    assert(ply < MAX_PLY);
 
-    {
-        std::lock_guard<std::mutex> lock(moveCacheMutex);
-        auto it = moveCache.find(boardHash);
-        if (it != moveCache.end()) {
-            cacheHitCount++;
-            return std::vector<Move>(it->second);
+    thread.pvLength[ply] = 0;
+    if (depth <= 0) return quiescence(board, thread, ply, alpha, beta);
+
+    if (++thread.nodes % SearchControl::CHECK_INTERVAL == 0) searchControl.checkTime();
+    if (isAborted(thread)) return 0.0f;
+
+    // Few enough men left for the tablebases to know the result, the distance to it only matters at the root
+    if (popcount(position.getOccupied()) <= tablebases.getMaxMen()) {
+        TablebaseWdl wdl;
+        if (tablebases.probe(position, wdl)) {
+            return wdl == TB_DRAW ? 0.0f : wdl == TB_WIN ? TB_WIN_SCORE - ply : ply - TB_WIN_SCORE;
+        }
+    }
+
+    // Off the principal variation every window is null, the search only asks whether a move beats alpha
+    const bool pvNode = beta - alpha > 1.0f;
+
+    Move* killers = thread.killers[ply];
+
+    // Only null windows take cutoffs from the table, on the principal variation they would cut the line short
+    const uint64_t key = position.getHash();
+    TTData entry;
+    Move ttMove = Move::none();
+    if (transpositionTable.probe(key, entry)) {
+        ttMove = entry.move;
+
+        if (!pvNode && entry.depth >= depth) {
+            float score = scoreFromTT(entry.score, ply);
+            if (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && score >= beta) ||
+                (entry.bound == BOUND_UPPER && score <= alpha)) {
+                return score;
+            }
         }
     }
 
-    auto availableMoves = std::vector<Move>();
-    uint64_t boardPieces = board->getColorBitboard(isWhite);
+    const bool inCheck = position.isInCheck();
+    const float staticEval = static_cast<float>(position.isWhiteToMove() ? position.getEval() : -position.getEval());
+
+    if (!pvNode && !inCheck && !isDecisive(beta)) {
+        // Reverse futility: so far above beta that even losing a margin per ply left would not bring it down
+        if (pruning.reverseFutility && depth <= REVERSE_FUTILITY_MAX_DEPTH &&
+            staticEval - static_cast<float>(REVERSE_FUTILITY_MARGIN * depth) >= beta) {
+            return staticEval;
+        }
+
+        // Null move: if passing the turn still holds beta, some real move will too. Never twice in a row, and not
+        // with only pawns left where zugzwang is common.
+        if (pruning.nullMove && depth >= NULL_MOVE_MIN_DEPTH && staticEval >= beta &&
+            position.getLastMove() != Move::none() && hasNonPawnMaterial(position)) {
+            int nullDepth = depth - 1 - NULL_MOVE_REDUCTION - depth / 4;
+
+            board.makeNullMove();
+            float score = -negamax(board, thread, nullDepth, ply + 1, -beta, -beta + 1.0f);
+            board.unmakeNullMove();
+
+            if (isAborted(thread)) return 0.0f;
+
+            // A mate or tablebase win found after passing is not proven, the side to move may have had to pass into it
+            if (score >= beta) return isDecisive(score) ? beta : score;
+        }
+    }
 
-    while (boardPieces) {
-        int index = ctz(boardPieces);
-        int x = index % 8;
-        int y = index / 8;
+    // Futility: near the leaves, a quiet move is not going to make up the gap between the static eval and alpha
+    const bool futile = pruning.futility && !inCheck && depth <= FUTILITY_MAX_DEPTH &&
+                        !isDecisive(alpha) &&
+                        staticEval + static_cast<float>(FUTILITY_MARGIN * depth) <= alpha;
 
-        auto moves = board->getValidMoves(x, y);
+    const float alphaOrig = alpha;
+    float bestScore = -1e9f;
+    Move bestMove = Move::none();
 
-        while (moves) {
-            int moveIndex = ctz(moves);
-            int newX = moveIndex % 8;
-            int newY = moveIndex / 8;
+    MovePicker picker(position, ttMove, killers, thread.history);
+    int legalMoves = 0;
+    Move quietsTried[MAX_MOVES];
+    int quietCount = 0;
+
+    for (Move move = picker.next(); move != Move::none(); move = picker.next()) {
+        legalMoves++;
+        bool quiet = isQuietMove(position, move);
+
+        // The first move is always searched, it gives the node a score
+        if (futile && quiet && legalMoves > 1) continue;
+        evaluatedMoves++;
+
+        // Late quiet moves are unlikely to be best, their null window search is also shallower
+        int reduction = 0;
+        if (pruning.lateMoveReductions && quiet && !inCheck && depth >= LMR_MIN_DEPTH &&
+            legalMoves > LMR_FULL_DEPTH_MOVES && move != killers[0] && move != killers[1]) {
+            reduction = lateMoveReduction(depth, legalMoves, thread.history.getHistory(position.isWhiteToMove(), move));
+        }
+
+        // The first move gets the full window. The others only have to be shown no better than alpha, one that
+        // beats it is searched again at full depth, then with the full window. An aborted child's score is
+        // meaningless, so it never leads to a re-search.
+        board.makeMove(move);
+        float score;
+        if (legalMoves == 1) {
+            score = -negamax(board, thread, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            score = -negamax(board, thread, depth - 1 - reduction, ply + 1, -alpha - 1.0f, -alpha);
+            if (score > alpha && reduction > 0 && !isAborted(thread)) {
+                score = -negamax(board, thread, depth - 1, ply + 1, -alpha - 1.0f, -alpha);
+            }
+            if (score > alpha && score < beta && !isAborted(thread)) {
+                score = -negamax(board, thread, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        board.unmakeMove();
 
-            Move move = {x, y, newX, newY, 0};
+        // Before the score touches alpha, the line or the move ordering stats
+        if (isAborted(thread)) return 0.0f;
 
-            availableMoves.push_back(move);
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+                thread.updatePv(ply, move);
+            }
+        }
 
-            moves &= moves - 1;
+        if (alpha >= beta) {
+            // beta cutoff, a quiet move that refutes here likely refutes the siblings too
+            if (quiet) thread.updateQuietStats(position, ply, depth, move, quietsTried, quietCount);
+            break;
         }
+        if (quiet) quietsTried[quietCount++] = move;
+
+        // Young brothers wait: with the eldest searched, idle threads may take the rest
+        if (mode == YBWC && depth >= MIN_SPLIT_DEPTH && idleHelpers.load(std::memory_order_relaxed) > 0) {
+            SplitPoint splitPoint;
+            splitPoint.position = position;
+            splitPoint.parent = thread.splitPoint;
+            splitPoint.depth = depth;
+            splitPoint.ply = ply;
+            splitPoint.beta = beta;
+            splitPoint.alpha = alpha;
+            splitPoint.bestScore = bestScore;
+            splitPoint.bestMove = bestMove;
+            for (Move rest = picker.next(); rest != Move::none(); rest = picker.next()) {
+                splitPoint.moves[splitPoint.moveCount++] = rest;
+            }
+            legalMoves += splitPoint.moveCount;
 
-        boardPieces &= boardPieces - 1;
+            split(board, thread, splitPoint);
+            if (isAborted(thread)) return 0.0f;
+
+            alpha = splitPoint.alpha;
+            bestScore = splitPoint.bestScore;
+            bestMove = splitPoint.bestMove;
+            if (splitPoint.pvLength > 0) {
+                std::copy(splitPoint.pv, splitPoint.pv + splitPoint.pvLength, thread.pv[ply]);
+                thread.pvLength[ply] = splitPoint.pvLength;
+            }
+            if (alpha >= beta && isQuietMove(position, bestMove)) {
+                thread.updateQuietStats(position, ply, depth, bestMove, nullptr, 0);
+            }
+            break;
+        }
     }
 
-    {
-        std::lock_guard<std::mutex> lock(moveCacheMutex);
-        moveCache[boardHash] = availableMoves;
+    // No legal moves ends the game, sooner mates score higher for the winner
+    if (legalMoves == 0) return inCheck ? -(MATE_SCORE - static_cast<float>(ply)) : 0.0f;
+
+    if (!isAborted(thread)) {
+        Bound bound = bestScore <= alphaOrig ? BOUND_UPPER : bestScore >= beta ? BOUND_LOWER : BOUND_EXACT;
+        transpositionTable.store(key, bestMove, scoreToTT(bestScore, ply), depth, bound);
     }
-    return availableMoves;
+
+    return bestScore;
 }
 
-float AI::minimax(ChessBoard* const board, int depth, float alpha, float beta, bool isWhiteToMove) {
-    if (depth == 0) {
-        return evaluatePosition(board);
+// Captures only until the position is quiet, so the static eval is never taken in the middle of an exchange.
+// Negamax, scores are for the side to move.
+float AI::quiescence(ChessBoard& board, ThreadData& thread, int ply, float alpha, float beta) {
+    const Position& position = board.getPosition();
+    const bool inCheck = position.isInCheck();
+
+    // Stand pat: the side to move may decline every capture, unless it is in check
+    float standPat = static_cast<float>(position.isWhiteToMove() ? position.getEval() : -position.getEval());
+    if (ply >= MAX_PLY - 1) return standPat;
+    if (!inCheck) {
+        if (standPat >= beta) return standPat;
+        if (standPat > alpha) alpha = standPat;
     }
 
-    auto currentTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime);
-    if (duration.count() > timeLimit) {
-        return evaluatePosition(board);
-    }
+    float bestScore = inCheck ? -1e9f : standPat;
+    MovePicker picker(position, thread.history);
+    int legalMoves = 0;
 
-    const bool maximizingPlayer = (isWhiteToMove == searchRootIsWhite);
-    float bestScore = maximizingPlayer ? -1e9f : 1e9f;
+    for (Move move = picker.next(); move != Move::none(); move = picker.next()) {
+        legalMoves++;
 
-    auto moves = generateMoves(board, isWhiteToMove);
+        if (!inCheck && move.flag() != PROMOTION) {
+            PieceType victim = move.flag() == EN_PASSANT ? PAWN : position.getPieceTypeAt(move.to());
+            int victimValue = PIECE_VALUES[victim];
 
-    for (const auto& move : moves) {
-        evaluatedMoves++;
+            // Delta pruning: even winning the piece for free would not reach alpha
+            if (standPat + victimValue + DELTA_MARGIN <= alpha) continue;
 
-        auto captured = board->getPieceTypeAt(move.toX, move.toY);
-        board->movePiece(move.fromX, move.fromY, move.toX, move.toY);
+            // A capture by a cheaper piece cannot lose material, only dearer ones need the exchange worked out
+            int attackerValue = PIECE_VALUES[position.getPieceTypeAt(move.from())];
+            if (attackerValue > victimValue && staticExchange(position, move) < 0) continue;
+        }
 
-        float score = minimax(board, depth - 1, alpha, beta, !isWhiteToMove);
+        evaluatedMoves++;
+        board.makeMove(move);
+        float score = -quiescence(board, thread, ply + 1, -beta, -alpha);
+        board.unmakeMove();
 
-        board->undoMove(move.fromX, move.fromY, move.toX, move.toY, captured);
+        // The clock is only read in negamax, but a raised flag unwinds the captures as well
+        if (isAborted(thread)) return 0.0f;
 
-        if (maximizingPlayer) {
-            if (score > bestScore) bestScore = score;
+        if (score > bestScore) {
+            bestScore = score;
             if (score > alpha) alpha = score;
-        } else {
-            if (score < bestScore) bestScore = score;
-            if (score < beta) beta = score;
-        }
-
-        if (beta <= alpha) {
-            break;  // alpha-beta cutoff
+            if (alpha >= beta) break;
         }
     }
 
+    if (inCheck && legalMoves == 0) return -(MATE_SCORE - static_cast<float>(ply));
     return bestScore;
 }
 
-float AI::evaluatePosition(const ChessBoard* const board) const {
-    auto evalColor = [&](bool isWhite) -> float {
-        float score = 0.0f;
+bool AI::isAborted(const ThreadData& thread) const {
+    if (searchControl.isStopped() || (thread.isHelper && helpersStop.load(std::memory_order_relaxed))) return true;
+    for (const SplitPoint* splitPoint = thread.splitPoint; splitPoint; splitPoint = splitPoint->parent) {
+        if (splitPoint->cutoff.load(std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+void AI::split(ChessBoard& board, ThreadData& thread, SplitPoint& splitPoint) {
+    {
+        std::lock_guard<std::mutex> lock(splitMutex);
+        if (splitPointCount < MAX_SPLIT_POINTS) splitPoints[splitPointCount++] = &splitPoint;
+    }
+    splitCv.notify_all();
+
+    // The owner works through the moves too, and stops early when a helper finds a cutoff
+    const SplitPoint* outer = thread.splitPoint;
+    thread.splitPoint = &splitPoint;
+    searchSplitPoint(board, thread, splitPoint);
+    thread.splitPoint = outer;
+
+    // Close it to new helpers, then wait for the ones still searching a move of it
+    std::unique_lock<std::mutex> lock(splitMutex);
+    SplitPoint** end = splitPoints + splitPointCount;
+    SplitPoint** found = std::find(splitPoints, end, &splitPoint);
+    if (found != end) {
+        *found = splitPoints[--splitPointCount];
+    }
+    splitCv.wait(lock, [&]() { return splitPoint.helpers == 0; });
+}
 
-        uint64_t pawns = board->getPieceBitboard(PAWN, isWhite);
-        uint64_t rooks = board->getPieceBitboard(ROOK, isWhite);
-        uint64_t knights = board->getPieceBitboard(KNIGHT, isWhite);
-        uint64_t bishops = board->getPieceBitboard(BISHOP, isWhite);
-        uint64_t queens = board->getPieceBitboard(QUEEN, isWhite);
-        uint64_t kings = board->getPieceBitboard(KING, isWhite);
+// Shared by the owner and its helpers, each on its own board at the split point's position. Every move here is a
+// younger brother, searched with a null window first.
+void AI::searchSplitPoint(ChessBoard& board, ThreadData& thread, SplitPoint& splitPoint) {
+    const int ply = splitPoint.ply;
+    const float beta = splitPoint.beta;
+
+    while (true) {
+        Move move;
+        float alpha;
+        {
+            std::lock_guard<std::mutex> lock(splitPoint.mutex);
+            if (splitPoint.nextMove == splitPoint.moveCount || isAborted(thread)) return;
+            move = splitPoint.moves[splitPoint.nextMove++];
+            alpha = splitPoint.alpha;
+        }
 
-        auto accumulatePieceScore = [&](uint64_t bits, PieceType piece) {
-            while (bits) {
-                int idx = ctz(bits);
-                int x = idx & 7;
-                int y = idx >> 3;
+        evaluatedMoves++;
+        board.makeMove(move);
+        const int depth = splitPoint.depth - 1;
+        float score = -negamax(board, thread, depth, ply + 1, -alpha - 1.0f, -alpha);
+        if (score > alpha && score < beta && !isAborted(thread)) {
+            score = -negamax(board, thread, depth, ply + 1, -beta, -alpha);
+        }
+        board.unmakeMove();
+
+        if (isAborted(thread)) return;
 
-                score += getValueForPiece(piece);
-                score += piecePositionScore(x, y, piece, isWhite);
+        std::lock_guard<std::mutex> lock(splitPoint.mutex);
+        if (score > splitPoint.bestScore) {
+            splitPoint.bestScore = score;
+            splitPoint.bestMove = move;
+        }
+
+        if (score > splitPoint.alpha) {
+            splitPoint.alpha = score;
+            splitPoint.pv[0] = move;
+            std::copy(thread.pv[ply + 1], thread.pv[ply + 1] + thread.pvLength[ply + 1], splitPoint.pv + 1);
+            splitPoint.pvLength = thread.pvLength[ply + 1] + 1;
+        }
 
-                bits &= bits - 1;
+        if (splitPoint.alpha >= beta) splitPoint.cutoff = true;
+    }
+}
+
+// A YBWC helper: joins open split points until the iteration is over
+void AI::helperLoop(ThreadData& thread) {
+    std::unique_lock<std::mutex> lock(splitMutex);
+    while (true) {
+        SplitPoint* splitPoint = nullptr;
+        auto findOpen = [&]() {
+            for (int i = 0; i < splitPointCount; ++i) {
+                std::lock_guard<std::mutex> splitLock(splitPoints[i]->mutex);
+                if (!splitPoints[i]->cutoff && splitPoints[i]->nextMove < splitPoints[i]->moveCount) {
+                    splitPoint = splitPoints[i];
+                    return true;
+                }
             }
+            return false;
         };
 
-        accumulatePieceScore(pawns, PAWN);
-        accumulatePieceScore(rooks, ROOK);
-        accumulatePieceScore(knights, KNIGHT);
-        accumulatePieceScore(bishops, BISHOP);
-        accumulatePieceScore(queens, QUEEN);
-        accumulatePieceScore(kings, KING);
+        ++idleHelpers;
+        splitCv.wait(lock, [&]() { return iterationDone || findOpen(); });
+        --idleHelpers;
+        if (iterationDone) return;
 
-        return score;
-    };
+        splitPoint->helpers++;
+        lock.unlock();
 
-    float whiteScore = evalColor(ChessBoard::WHITE);
-    float blackScore = evalColor(ChessBoard::BLACK);
+        ChessBoard board(splitPoint->position);
+        thread.splitPoint = splitPoint;
+        searchSplitPoint(board, thread, *splitPoint);
+        thread.splitPoint = nullptr;
 
-    float score = whiteScore - blackScore;
-    return searchRootIsWhite ? score : -score;
+        lock.lock();
+        if (--splitPoint->helpers == 0) splitCv.notify_all();
+    }
 }
 
-int AI::piecePositionScore(int x, int y, const PieceType type, bool isWhite) const {
-    int idx = y * 8 + x;
-
-    if (!isWhite) {
-        idx = 63 - idx;
-    }
-
-    switch (type) {
-        case PAWN:
-            return PAWN_TABLE[idx];
-        case KNIGHT:
-            return KNIGHT_TABLE[idx];
-        case BISHOP:
-            return BISHOP_TABLE[idx];
-        case ROOK:
-            return ROOK_TABLE[idx];
-        case QUEEN:
-            return QUEEN_TABLE[idx];
-        case KING:
-            return KING_TABLE[idx];
-        default:
-            return 0;
-    }
+int AI::scoreToTT(float score, int ply) {
+    int value = static_cast<int>(score);
+    if (value >= DECISIVE_SCORE) value += ply;
+    if (value <= -DECISIVE_SCORE) value -= ply;
+    return std::clamp(value, -32767, 32767);
 }
 
-float AI::getValueForPiece(const PieceType piece) const {
-    switch (piece) {
-        case PAWN:
-            return 100;
-        case KNIGHT:
-            return 320;
-        case BISHOP:
-            return 330;
-        case ROOK:
-            return 500;
-        case QUEEN:
-            return 900;
-        case KING:
-            return 20000;
-        default:
-            return 0;
-    }
-}
\ No newline at end of file
+float AI::scoreFromTT(int score, int ply) {
+    if (score >= DECISIVE_SCORE) score -= ply;
+    if (score <= -DECISIVE_SCORE) score += ply;
+    return static_cast<float>(score);
+}
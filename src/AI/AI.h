@@ -1,53 +1,286 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "../Chess/ChessBoard.h"
+#include "../Chess/Move.h"
+#include "../Chess/MoveGen.h"
 #include "../Chess/PieceType.h"
 #include "../Thread/ThreadPool.h"
+#include "History.h"
+#include "OpeningBook.h"
+#include "SearchControl.h"
+#include "Tablebase.h"
+#include "TranspositionTable.h"
 
-struct Move {
-    int fromX, fromY;
-    int toX, toY;
-    float score;
+/*
+ * How the search uses its threads:
+ *  - ROOT_SPLIT  every root move is a task with a full window, threads never share cutoffs
+ *  - LAZY_SMP    every thread searches the whole tree, sharing only the transposition table
+ *  - YBWC        one search, a node hands its remaining moves to idle threads once its first move is searched
+ */
+enum SearchMode { ROOT_SPLIT, LAZY_SMP, YBWC };
+
+// "root", "lazy_smp" or "ybwc", LAZY_SMP for anything else
+SearchMode searchModeFromString(const std::string& name);
+const char* searchModeToString(SearchMode mode);
+
+// The selective search, every technique can be turned off on its own to measure what it is worth
+struct PruningOptions {
+    bool nullMove = true;
+    bool lateMoveReductions = true;
+    bool futility = true;
+    bool reverseFutility = true;
 };
 
 class AI {
 public:
-    AI(int maxDepth, int timeLimit) : maxDepth(maxDepth), timeLimit(timeLimit) {}
+    // threads 0 uses every core
+    AI(int maxDepth, int timeLimit, int hashSize, int threads, SearchMode mode);
 
     AI(const AI&) = delete;
     AI& operator=(const AI&) = delete;
 
     void makeMove(ChessBoard* board, bool isWhite);
+    Move findBestMove(const ChessBoard* const board, bool isWhite);
+    int64_t getEvaluatedMoves() const { return evaluatedMoves; }
+
+    // Takes effect from the next search
+    void setPruning(const PruningOptions& options) { pruning = options; }
+
+    // Polyglot book for makeMove to play from before searching, false if it cannot be loaded
+    bool loadBook(const std::string& bookPath) { return book.open(bookPath); }
+
+    // Endgame tablebases for the search to look positions up in, returns how many were loaded
+    int loadTablebases(const std::string& directory) { return tablebases.load(directory); }
 
-    ~AI() { threadpool.join(); }
+    // After each move, makeMove goes on searching the reply it expects until the next call
+    void setPonder(bool enabled) { ponder = enabled; }
+
+    // Makes a running search return its best move so far, safe to call from any thread
+    void stop() { searchControl.stop(); }
+
+    // Of the last completed iteration of the last search, written by the pondering search until the next makeMove
+    int getCompletedDepth() const { return completedDepth; }
+    const std::vector<Move>& getPrincipalVariation() const { return principalVariation; }
+
+    // Heap allocations made inside the search during the last search, expected to be 0
+    uint64_t getSearchAllocations() const { return searchAllocations; }
+
+    ~AI() {
+        if (ponderThread.joinable()) {
+            searchControl.stop();
+            ponderThread.join();
+        }
+        threadpool.join();
+    }
+
+    // Far above any material balance, minus the ply of the mate
+    static constexpr float MATE_SCORE = 30000.0f;
 
 private:
+    static constexpr int MAX_PLY = 64;
+
+    // A tablebase win, below every mate the search can see so a found mate is still preferred
+    static constexpr float TB_WIN_SCORE = MATE_SCORE - 2 * MAX_PLY;
+
+    // Mates and tablebase wins, both scored by their distance from the root
+    static constexpr float DECISIVE_SCORE = TB_WIN_SCORE - MAX_PLY;
+    static bool isDecisive(float score) { return std::abs(score) >= DECISIVE_SCORE; }
+
+    // Margin over the captured piece's value before delta pruning gives up on a capture
+    static constexpr int DELTA_MARGIN = 200;
+
+    // Aspiration: the first window around the last iteration's score, doubled on every fail and opened fully past
+    // the maximum
+    static constexpr int ASPIRATION_MIN_DEPTH = 4;
+    static constexpr float ASPIRATION_WINDOW = 50.0f;
+    static constexpr float ASPIRATION_MAX_WINDOW = 800.0f;
+
+    // Null move: searched this much shallower, more as the depth grows
+    static constexpr int NULL_MOVE_MIN_DEPTH = 3;
+    static constexpr int NULL_MOVE_REDUCTION = 2;
+
+    // Late move reductions: quiet moves past the first few, once there is depth enough to reduce
+    static constexpr int LMR_MIN_DEPTH = 3;
+    static constexpr int LMR_FULL_DEPTH_MOVES = 3;
+
+    // Futility: how far the static eval may move per ply left, the forward kind only skips quiet moves
+    static constexpr int FUTILITY_MAX_DEPTH = 2;
+    static constexpr int FUTILITY_MARGIN = 150;
+    static constexpr int REVERSE_FUTILITY_MAX_DEPTH = 3;
+    static constexpr int REVERSE_FUTILITY_MARGIN = 120;
+
+    // YBWC only splits nodes with enough work left to pay for the hand-off
+    static constexpr int MIN_SPLIT_DEPTH = 4;
+    static constexpr int MAX_SPLIT_POINTS = 64;
+
+    // A node whose remaining moves are shared between its owner and idle helpers, lives on the owner's stack
+    struct SplitPoint {
+        Position position;
+        const SplitPoint* parent;
+        int depth;
+        int ply;
+        float beta;
+
+        // under mutex
+        std::mutex mutex;
+        Move moves[MAX_MOVES];
+        int moveCount = 0;
+        int nextMove = 0;
+        float alpha;
+        float bestScore;
+        Move bestMove;
+        Move pv[MAX_PLY];
+        int pvLength = 0;
+
+        // under splitMutex
+        int helpers = 0;
+
+        std::atomic<bool> cutoff = false;
+    };
+
+    // Owned by one search thread, never shared between threads
+    struct ThreadData {
+        // the last two quiet moves that caused a cutoff at each ply
+        Move killers[MAX_PLY][2] = {};
+        HistoryTables history;
+
+        // interior nodes searched, the clock is read every SearchControl::CHECK_INTERVAL of them
+        uint32_t nodes = 0;
+
+        // Triangular principal variation, the line from each ply on found by its last search
+        Move pv[MAX_PLY][MAX_PLY];
+        int pvLength[MAX_PLY] = {};
+
+        // A Lazy SMP helper, stopped when the main thread completes its iteration
+        bool isHelper = false;
+
+        // The innermost split point this thread works for, its result is moot once any of them cuts off
+        const SplitPoint* splitPoint = nullptr;
+
+        // Killers belong to the plies of the last search. When the game went on along its line they move up the
+        // two plies played, otherwise they are cleared. History only fades.
+        void newSearch(bool followsLine) {
+            for (int ply = 0; ply < MAX_PLY; ++ply) {
+                bool carried = followsLine && ply + 2 < MAX_PLY;
+                killers[ply][0] = carried ? killers[ply + 2][0] : Move::none();
+                killers[ply][1] = carried ? killers[ply + 2][1] : Move::none();
+            }
+            history.age();
+        }
+
+        // A quiet move cut off: it becomes a killer and the countermove and gains history, the quiet moves tried
+        // before it lose as much
+        void updateQuietStats(const Position& position, int ply, int depth, Move move, const Move* tried,
+                              int triedCount) {
+            bool isWhite = position.isWhiteToMove();
+            int bonus = std::min(16 * depth * depth, 2048);
+            history.addHistory(isWhite, move, bonus);
+            for (int i = 0; i < triedCount; ++i) history.addHistory(isWhite, tried[i], -bonus);
+            history.setCounterMove(position, move);
+
+            if (move == killers[ply][0]) return;
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = move;
+        }
+
+        void updatePv(int ply, Move move) {
+            pv[ply][0] = move;
+            int length = ply + 1 < MAX_PLY ? pvLength[ply + 1] : 0;
+            std::copy(pv[ply + 1], pv[ply + 1] + length, pv[ply] + 1);
+            pvLength[ply] = length + 1;
+        }
+    };
+
+    // A move at the root with the score and line of its last completed search
+    struct RootMove {
+        Move move;
+        float score = -1e9f;
+        Move pv[MAX_PLY];
+        int pvLength = 0;
+    };
+
     const int maxDepth;
     const int timeLimit;
-    std::atomic<int> cacheHitCount{0};
-    std::atomic<int64_t> evaluatedMoves = 0;
+    const int threads;
+    const SearchMode mode;
+    PruningOptions pruning;
+    bool ponder = false;
 
-    bool searchRootIsWhite;
+    // Shared by every search task and kept between moves
+    TranspositionTable transpositionTable;
+
+    // One per thread, the first for the main search, kept between moves for their history
+    std::vector<std::unique_ptr<ThreadData>> threadData;
+
+    int completedDepth = 0;
+    std::vector<Move> principalVariation;
+
+    // The position two plies down the last principal variation, and the line from there
+    uint64_t expectedRootHash = 0;
+    std::vector<Move> expectedLine;
+    std::atomic<int64_t> evaluatedMoves = 0;
+    std::atomic<uint64_t> searchAllocations = 0;
 
     ThreadPool threadpool;
 
-    // move cache
-    std::unordered_map<uint64_t, std::vector<Move>> moveCache;
-    std::mutex moveCacheMutex;
+    // Once stopped, scores are not worth storing or returning
+    SearchControl searchControl;
 
-    std::chrono::steady_clock::time_point startTime;
+    OpeningBook book;
+    Tablebases tablebases;
 
-    // evals
-    Move findBestMove(const ChessBoard* const board, bool isWhite);
-    float evaluatePosition(const ChessBoard* const board) const;
-    int piecePositionScore(int x, int y, const PieceType type, bool isWhite) const;
-    float getValueForPiece(const PieceType piece) const;
-    float minimax(ChessBoard* const board, int depth, float alpha, float beta, bool isWhiteToMove);
+    // Drives the search of the position after the expected reply, the pool helps it as in any search
+    std::thread ponderThread;
+    uint64_t ponderHash = 0;
+    Move ponderMove;
+
+    // Raised when the Lazy SMP main thread finishes an iteration
+    std::atomic<bool> helpersStop = false;
+
+    // YBWC split points open for helpers, and the helpers waiting for one
+    std::mutex splitMutex;
+    std::condition_variable splitCv;
+    SplitPoint* splitPoints[MAX_SPLIT_POINTS];
+    int splitPointCount = 0;
+    std::atomic<int> idleHelpers = 0;
+    bool iterationDone = false;
+
+    // Decisive scores are stored relative to the node, so they stay valid when reached at another ply
+    static int scoreToTT(float score, int ply);
+    static float scoreFromTT(int score, int ply);
+
+    // Checks the conversions above
+    friend int runSelfTest(int argc, char* argv[]);
+
+    Move iterativeDeepening(const Position& root);
+    void seedExpectedLine(const Position& root);
+    Move tablebaseMove(const Position& root) const;
+    void startPondering(const Position& root);
+    Move finishPondering(const Position& position);
+
+    // Each returns the best score of the root moves, a bound when outside the window
+    float searchRoot(const Position& root, RootMove* rootMoves, int moveCount, int depth, float alpha, float beta);
+    float searchRootSplit(const Position& root, RootMove* rootMoves, int moveCount, int depth, float alpha,
+                          float beta);
+    float searchRootMoves(ChessBoard& board, ThreadData& thread, RootMove* rootMoves, int moveCount, int depth,
+                          float alpha, float beta);
+    bool isAborted(const ThreadData& thread) const;
 
-    // move generation
-    std::vector<Move> generateMoves(const ChessBoard* const board, bool isWhite);
+    // YBWC
+    void split(ChessBoard& board, ThreadData& thread, SplitPoint& splitPoint);
+    void searchSplitPoint(ChessBoard& board, ThreadData& thread, SplitPoint& splitPoint);
+    void helperLoop(ThreadData& thread);
+    float negamax(ChessBoard& board, ThreadData& thread, int depth, int ply, float alpha, float beta);
+    float quiescence(ChessBoard& board, ThreadData& thread, int ply, float alpha, float beta);
 };
\ No newline at end of file
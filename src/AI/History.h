@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "../Chess/Move.h"
+#include "../Chess/PieceType.h"
+#include "../Chess/Position.h"
+
+/*
+ * What one search thread has learned about quiet moves, to order them:
+ *  - butterfly history, by side, from and to square, raised for moves that cut off and lowered for the quiet
+ *    moves tried before them
+ *  - countermoves, the quiet move that last refuted each opponent move, by side, piece and target square
+ *
+ * Kept between searches and halved at the start of each one, so statistics of old positions fade.
+ */
+struct HistoryTables {
+    static constexpr int MAX_HISTORY = 16384;
+
+    int16_t history[2][64][64] = {};
+    Move counterMoves[2][6][64] = {};
+
+    int getHistory(bool isWhite, Move move) const { return history[isWhite][move.from()][move.to()]; }
+
+    // The bonus shrinks as the entry nears MAX_HISTORY, so entries saturate instead of overflowing
+    void addHistory(bool isWhite, Move move, int bonus) {
+        int16_t& entry = history[isWhite][move.from()][move.to()];
+        entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+    }
+
+    // The quiet move that last refuted the move that led here
+    Move getCounterMove(const Position& position) const {
+        Move previous = position.getLastMove();
+        PieceType piece = previous == Move::none() ? EMPTY : position.getPieceTypeAt(previous.to());
+        return piece == EMPTY ? Move::none() : counterMoves[!position.isWhiteToMove()][piece][previous.to()];
+    }
+
+    void setCounterMove(const Position& position, Move move) {
+        Move previous = position.getLastMove();
+        PieceType piece = previous == Move::none() ? EMPTY : position.getPieceTypeAt(previous.to());
+        if (piece != EMPTY) counterMoves[!position.isWhiteToMove()][piece][previous.to()] = move;
+    }
+
+    void age() {
+        for (auto& side : history) {
+            for (auto& from : side) {
+                for (int16_t& entry : from) entry /= 2;
+            }
+        }
+    }
+};
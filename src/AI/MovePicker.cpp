@@ -0,0 +1,135 @@
+#include "MovePicker.h"
+
+#include <utility>
+
+// Rough piece values for ordering only, indexed by PieceType
+constexpr int16_t ORDER_VALUE[6] = {1, 5, 3, 3, 9, 10};
+
+MovePicker::MovePicker(const Position& position, Move ttMove, const Move killers[2], const HistoryTables& history)
+    : position(position), info(position), ttMove(ttMove), killers{killers[0], killers[1]}, history(history) {
+    stage = ttMove != Move::none() && isLegalMove(position, info, ttMove) ? PICK_TT_MOVE : GENERATE_CAPTURES;
+}
+
+MovePicker::MovePicker(const Position& position, const HistoryTables& history)
+    : position(position),
+      info(position),
+      ttMove(Move::none()),
+      killers{Move::none(), Move::none()},
+      history(history),
+      capturesOnly(!info.checkers),
+      stage(GENERATE_CAPTURES) {}
+
+Move MovePicker::next() {
+    switch (stage) {
+        case PICK_TT_MOVE:
+            stage = GENERATE_CAPTURES;
+            return ttMove;
+
+        case GENERATE_CAPTURES:
+            current = 0;
+            end = static_cast<int>(generateMoves<CAPTURES>(position, info, moves) - moves);
+            scoreCaptures();
+            stage = PICK_CAPTURES;
+            [[fallthrough]];
+
+        case PICK_CAPTURES:
+            while (current < end) {
+                Move move = pickBest();
+                if (move != ttMove) return move;
+            }
+            if (capturesOnly) {
+                stage = DONE;
+                break;
+            }
+            stage = PICK_KILLERS;
+            [[fallthrough]];
+
+        case PICK_KILLERS:
+            // Killers come from sibling nodes, so they must be checked against this position
+            while (killerIndex < 2) {
+                Move killer = killers[killerIndex++];
+                if (killer != Move::none() && killer != ttMove && isQuietMove(position, killer) &&
+                    isLegalMove(position, info, killer)) {
+                    return killer;
+                }
+            }
+            stage = PICK_COUNTER_MOVE;
+            [[fallthrough]];
+
+        case PICK_COUNTER_MOVE: {
+            stage = GENERATE_QUIETS;
+            Move counter = history.getCounterMove(position);
+            if (counter != Move::none() && counter != ttMove && counter != killers[0] && counter != killers[1] &&
+                isQuietMove(position, counter) && isLegalMove(position, info, counter)) {
+                counterMove = counter;
+                return counter;
+            }
+            [[fallthrough]];
+        }
+
+        case GENERATE_QUIETS:
+            current = 0;
+            end = static_cast<int>(generateMoves<QUIETS>(position, info, moves) - moves);
+            sortQuiets();
+            stage = PICK_QUIETS;
+            [[fallthrough]];
+
+        case PICK_QUIETS:
+            while (current < end) {
+                Move move = moves[current++];
+                if (!isPickedEarly(move)) return move;
+            }
+            stage = DONE;
+            [[fallthrough]];
+
+        case DONE:
+            break;
+    }
+
+    return Move::none();
+}
+
+// Moves already returned by an earlier stage
+bool MovePicker::isPickedEarly(Move move) const {
+    return move == ttMove || move == killers[0] || move == killers[1] || move == counterMove;
+}
+
+void MovePicker::scoreCaptures() {
+    for (int i = 0; i < end; ++i) {
+        Move move = moves[i];
+        PieceType victim = move.flag() == EN_PASSANT ? PAWN : position.getPieceTypeAt(move.to());
+        PieceType attacker = position.getPieceTypeAt(move.from());
+
+        int16_t score = victim == EMPTY ? 0 : ORDER_VALUE[victim] * 16 - ORDER_VALUE[attacker];
+        if (move.flag() == PROMOTION) score += ORDER_VALUE[move.promotion()] * 16;
+        scores[i] = score;
+    }
+}
+
+// Sorted at once by insertion, nodes that get this far usually search most of their quiet moves
+void MovePicker::sortQuiets() {
+    bool isWhite = position.isWhiteToMove();
+    for (int i = 0; i < end; ++i) {
+        Move move = moves[i];
+        int16_t score = static_cast<int16_t>(history.getHistory(isWhite, move));
+        int j = i;
+        for (; j > 0 && scores[j - 1] < score; --j) {
+            moves[j] = moves[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        moves[j] = move;
+        scores[j] = score;
+    }
+}
+
+// One selection step instead of a full sort, most nodes cut off after the first few captures
+Move MovePicker::pickBest() {
+    int best = current;
+    for (int i = current + 1; i < end; ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+
+    std::swap(moves[current], moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves[current++];
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../Chess/Move.h"
+#include "../Chess/MoveGen.h"
+#include "../Chess/Position.h"
+#include "History.h"
+
+// Moves onto an empty square that promote nothing, the only ones that can be killers
+inline bool isQuietMove(const Position& position, Move move) {
+    return position.getPieceTypeAt(move.to()) == EMPTY && move.flag() != PROMOTION && move.flag() != EN_PASSANT;
+}
+
+/*
+ * Hands out the legal moves of a node one at a time, best guess first:
+ *  - the hash move, if it is legal here
+ *  - captures and promotions, most valuable victim by least valuable attacker
+ *  - the killer moves of this ply
+ *  - the countermove to the previous move
+ *  - the remaining quiet moves by history score
+ *
+ * Each stage is generated only when the previous one is used up, so a node that cuts off on a capture never
+ * generates its quiet moves.
+ */
+class MovePicker {
+public:
+    MovePicker(const Position& position, Move ttMove, const Move killers[2], const HistoryTables& history);
+
+    // Captures and promotions only for the quiescence search, or every evasion when in check
+    MovePicker(const Position& position, const HistoryTables& history);
+
+    MovePicker(const MovePicker&) = delete;
+    MovePicker& operator=(const MovePicker&) = delete;
+
+    // Move::none() once every legal move has been returned
+    Move next();
+
+private:
+    enum Stage {
+        PICK_TT_MOVE,
+        GENERATE_CAPTURES,
+        PICK_CAPTURES,
+        PICK_KILLERS,
+        PICK_COUNTER_MOVE,
+        GENERATE_QUIETS,
+        PICK_QUIETS,
+        DONE
+    };
+
+    bool isPickedEarly(Move move) const;
+    void scoreCaptures();
+    void sortQuiets();
+    Move pickBest();
+
+    const Position& position;
+    const CheckInfo info;
+    const Move ttMove;
+    const Move killers[2];
+    const HistoryTables& history;
+    const bool capturesOnly = false;
+    Move counterMove = Move::none();
+
+    Stage stage;
+    int current = 0;
+    int end = 0;
+    int killerIndex = 0;
+
+    Move moves[MAX_MOVES];
+    int16_t scores[MAX_MOVES];
+};
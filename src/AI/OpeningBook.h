@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "../Chess/Move.h"
+#include "../Chess/Position.h"
+#include "../Utils/MappedFile.h"
+
+/*
+ * A Polyglot opening book, memory-mapped and searched in place.
+ *
+ * The book is an array of 16-byte big-endian entries sorted by key: position key, move, weight, and a learn field
+ * this reader ignores. Positions are keyed with Polyglot's own Zobrist scheme and its 781 published Random64
+ * constants.
+ */
+class OpeningBook {
+public:
+    // False, with the book closed, if the file is missing or malformed
+    bool open(const std::string& bookPath);
+    bool isOpen() const { return book.isOpen(); }
+
+    // A book move for this position picked at random by weight, Move::none() if the book has none
+    Move probe(const Position& position);
+
+    static uint64_t polyglotKey(const Position& position);
+
+private:
+    static constexpr size_t ENTRY_SIZE = 16;
+    static constexpr uint64_t START_POSITION_KEY = 0x463B96181691FC9CULL;
+
+    MappedFile book;
+    std::mt19937 rng{std::random_device{}()};
+
+    size_t getEntryCount() const { return book.getSize() / ENTRY_SIZE; }
+    uint64_t getEntryKey(size_t index) const;
+
+    // The legal move a Polyglot move stands for, Move::none() if there is none
+    static Move decodeMove(const Position& position, uint16_t bookMove);
+};
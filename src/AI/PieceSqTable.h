@@ -1,4 +1,7 @@
 #pragma once
+
+#include "../Chess/PieceType.h"
+
 // clang-format off
 // All tables are from white's perspective
 constexpr static int PAWN_TABLE[64] = {
@@ -67,3 +70,35 @@ constexpr static int KING_TABLE[64] = {
      20, 30, 10,  0,  0, 10, 30, 20
 };
 // clang-format on
+
+// Material values indexed by PieceType
+constexpr int PIECE_VALUES[6] = {100, 500, 320, 330, 900, 20000};
+
+constexpr const int* PIECE_SQUARE_TABLES[6] = {PAWN_TABLE,   ROOK_TABLE,  KNIGHT_TABLE,
+                                               BISHOP_TABLE, QUEEN_TABLE, KING_TABLE};
+
+// Material plus piece-square bonus, black reads the tables rotated
+struct PieceSquareValues {
+    int values[2][6][64];
+};
+
+constexpr PieceSquareValues genPieceSquareValues() {
+    PieceSquareValues t{};
+
+    for (int piece = 0; piece < 6; ++piece) {
+        for (int sq = 0; sq < 64; ++sq) {
+            t.values[true][piece][sq] = PIECE_VALUES[piece] + PIECE_SQUARE_TABLES[piece][sq];
+            t.values[false][piece][sq] = PIECE_VALUES[piece] + PIECE_SQUARE_TABLES[piece][63 - sq];
+        }
+    }
+
+    return t;
+}
+
+inline constexpr PieceSquareValues PIECE_SQUARE_VALUES = genPieceSquareValues();
+
+// White's score minus black's for one piece
+constexpr int pieceSquareValue(int pieceType, bool isWhite, int square) {
+    return isWhite ? PIECE_SQUARE_VALUES.values[true][pieceType][square]
+                   : -PIECE_SQUARE_VALUES.values[false][pieceType][square];
+}
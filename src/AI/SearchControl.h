@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+ * When a search has to stop. Workers look at the clock only every CHECK_INTERVAL nodes, and anyone, the UI
+ * included, may raise the stop flag. Once it is up every worker unwinds at its next node.
+ *
+ * A pondering search has no time limit until ponderHit, the clock then starts over for the rest of the search.
+ */
+class SearchControl {
+public:
+    static constexpr uint32_t CHECK_INTERVAL = 2048;
+
+    void start(int timeLimit, bool ponder = false) {
+        this->timeLimit = timeLimit;
+        startTime = std::chrono::steady_clock::now();
+        hitTime = 0;
+        pondering = ponder;
+        stopped.store(false, std::memory_order_relaxed);
+    }
+
+    // The opponent played the move being pondered, the search is now on our own time
+    void ponderHit() {
+        hitTime = sinceStart();
+        pondering = false;
+    }
+    bool isPondering() const { return pondering; }
+
+    void stop() { stopped.store(true, std::memory_order_relaxed); }
+    bool isStopped() const { return stopped.load(std::memory_order_relaxed); }
+
+    // Raises the stop flag once the time limit has passed
+    void checkTime() {
+        if (!pondering && getElapsed() > timeLimit) stop();
+    }
+
+    // Milliseconds since start, or since the ponder hit
+    int64_t getElapsed() const { return sinceStart() - hitTime; }
+
+private:
+    std::atomic<bool> stopped = false;
+    std::atomic<bool> pondering = false;
+    std::atomic<int64_t> hitTime = 0;
+    int timeLimit = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    int64_t sinceStart() const {
+        auto elapsed = std::chrono::steady_clock::now() - startTime;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    }
+};
@@ -0,0 +1,75 @@
+#include "See.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "../Chess/AttackTables.h"
+#include "../Utils/bits.h"
+#include "PieceSqTable.h"
+
+// Least valuable first, PieceType is not ordered by value
+constexpr PieceType CAPTURE_ORDER[6] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+
+int staticExchange(const Position& position, Move move) {
+    int from = move.from();
+    int to = move.to();
+    bool side = position.isWhiteToMove();
+
+    uint64_t pieces[6];
+    for (int type = PAWN; type <= KING; ++type) {
+        pieces[type] = position.getPieceBitboard(static_cast<PieceType>(type), true) |
+                       position.getPieceBitboard(static_cast<PieceType>(type), false);
+    }
+    uint64_t diagonal = pieces[BISHOP] | pieces[QUEEN];
+    uint64_t straight = pieces[ROOK] | pieces[QUEEN];
+
+    uint64_t occupied = position.getOccupied() ^ (1ULL << from);
+    PieceType victim = position.getPieceTypeAt(to);
+    PieceType attacker = position.getPieceTypeAt(from);
+
+    // gain[d] is what the side making capture d has won if the other side stops there, the last one is only
+    // a guess that the other side can recapture
+    int gain[33];
+    gain[0] = victim == EMPTY ? 0 : PIECE_VALUES[victim];
+    if (move.flag() == EN_PASSANT) {
+        occupied ^= 1ULL << (side ? to + 8 : to - 8);
+        gain[0] = PIECE_VALUES[PAWN];
+    } else if (move.flag() == PROMOTION) {
+        attacker = move.promotion();
+        gain[0] += PIECE_VALUES[attacker] - PIECE_VALUES[PAWN];
+    }
+
+    uint64_t attackers = position.attackersTo(to, occupied) & occupied;
+    int depth = 0;
+
+    while (true) {
+        ++depth;
+        gain[depth] = PIECE_VALUES[attacker] - gain[depth - 1];
+
+        // Neither side can do better than stopping already
+        if (std::max(-gain[depth - 1], gain[depth]) < 0) break;
+
+        side = !side;
+        uint64_t own = attackers & position.getColorBitboard(side);
+        if (!own) break;
+
+        for (PieceType type : CAPTURE_ORDER) {
+            if (own & pieces[type]) {
+                attacker = type;
+                break;
+            }
+        }
+        occupied ^= 1ULL << ctz(own & pieces[attacker]);
+
+        // Sliders lined up behind the piece that just moved join in
+        if (attacker == PAWN || attacker == BISHOP || attacker == QUEEN) {
+            attackers |= bishopMoves(to, occupied) & diagonal;
+        }
+        if (attacker == ROOK || attacker == QUEEN) attackers |= rookMoves(to, occupied) & straight;
+        attackers &= occupied;
+    }
+
+    // Back down the sequence, each side only continues when that beats stopping
+    while (--depth > 0) gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    return gain[0];
+}
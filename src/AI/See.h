@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../Chess/Move.h"
+#include "../Chess/Position.h"
+
+// Material the side to move wins or loses on the target square of a move, if both sides keep capturing there
+// with their least valuable piece and may stop whenever that is better. Works on bitboards only, x-rays of
+// sliders behind the capturers included.
+int staticExchange(const Position& position, Move move);
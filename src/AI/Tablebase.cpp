@@ -0,0 +1,112 @@
+#include "Tablebase.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "../Utils/bits.h"
+
+std::string TablebaseMaterial::getName() const {
+    std::string name = "K";
+    for (int i = 0; i < count; ++i) name += pieceTypeToSymbol(pieces[i]);
+    return name + "K";
+}
+
+int Tablebases::load(const std::string& directory) {
+    tables.clear();
+    maxMen = 0;
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() != ".wdl") continue;
+
+        auto table = std::make_unique<Table>();
+        int wdlBits = 0;
+        TablebaseMaterial dtmMaterial;
+        std::filesystem::path dtmPath = entry.path();
+        dtmPath.replace_extension(".dtm");
+        if (!openFile(table->wdl, entry.path().string(), "TBWL", table->material, wdlBits) || wdlBits != 2 ||
+            !openFile(table->dtm, dtmPath.string(), "TBDM", dtmMaterial, table->dtmBits) ||
+            !(dtmMaterial == table->material)) {
+            continue;
+        }
+
+        maxMen = std::max(maxMen, table->material.count + 2);
+        tables.push_back(std::move(table));
+    }
+    return static_cast<int>(tables.size());
+}
+
+bool Tablebases::probe(const Position& position, TablebaseWdl& wdl, int* plies) const {
+    if (position.getCastlingRights() != 0) return false;
+
+    uint64_t kings = position.getPieceBitboard(KING, true) | position.getPieceBitboard(KING, false);
+    uint64_t whitePieces = position.getColorBitboard(true) & ~kings;
+    uint64_t blackPieces = position.getColorBitboard(false) & ~kings;
+    if ((whitePieces && blackPieces) || popcount(whitePieces | blackPieces) > TB_MAX_PIECES) return false;
+
+    // Seen from the side with the pieces, its pawns then always move north
+    bool strongIsWhite = blackPieces == 0;
+    int flip = strongIsWhite ? 0 : 56;
+
+    TablebaseMaterial material;
+    int squares[TB_MAX_PIECES];
+    for (PieceType type : TB_PIECE_ORDER) {
+        for (uint64_t bb = position.getPieceBitboard(type, strongIsWhite); bb; bb &= bb - 1) {
+            squares[material.count] = static_cast<int>(ctz(bb)) ^ flip;
+            material.pieces[material.count++] = type;
+        }
+    }
+
+    if (material.isDrawn()) {
+        wdl = TB_DRAW;
+        if (plies) *plies = 0;
+        return true;
+    }
+
+    auto table = std::find_if(tables.begin(), tables.end(), [&](const auto& t) { return t->material == material; });
+    if (table == tables.end()) return false;
+
+    int whiteKing = position.getKingSquare(strongIsWhite) ^ flip;
+    int blackKing = position.getKingSquare(!strongIsWhite) ^ flip;
+    bool whiteToMove = position.isWhiteToMove() == strongIsWhite;
+    size_t index = tablebaseIndex(whiteToMove, whiteKing, blackKing, squares, material.count);
+    wdl = static_cast<TablebaseWdl>(readEntry((*table)->wdl, 2, index));
+    if (wdl == TB_ILLEGAL) return false;
+    if (plies) *plies = readEntry((*table)->dtm, (*table)->dtmBits, index);
+    return true;
+}
+
+bool Tablebases::openFile(MappedFile& file, const std::string& path, const char* magic, TablebaseMaterial& material,
+                          int& bits) {
+    if (!file.open(path) || file.getSize() < sizeof(TablebaseHeader)) {
+        file.close();
+        return false;
+    }
+
+    TablebaseHeader header;
+    std::memcpy(&header, file.getData(), sizeof(header));
+
+    material.count = header.count;
+    bool valid = std::memcmp(header.magic, magic, 4) == 0 && header.version == TB_VERSION && header.bits >= 1 &&
+                 header.bits <= 8 && header.count >= 1 && header.count <= TB_MAX_PIECES;
+    for (int i = 0; valid && i < material.count; ++i) {
+        valid = header.pieces[i] <= QUEEN;
+        material.pieces[i] = static_cast<PieceType>(header.pieces[i]);
+    }
+
+    // Padded by a byte, so every entry can be read as two bytes
+    bits = header.bits;
+    if (!valid || file.getSize() < sizeof(header) + (tablebaseSize(material.count) * bits + 7) / 8 + 1) {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+int Tablebases::readEntry(const MappedFile& file, int bits, size_t index) {
+    size_t bit = index * bits;
+    const uint8_t* bytes = file.getData() + sizeof(TablebaseHeader) + bit / 8;
+    unsigned window = bytes[0] | (bytes[1] << 8);
+    return static_cast<int>((window >> (bit % 8)) & ((1u << bits) - 1));
+}
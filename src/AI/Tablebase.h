@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Chess/PieceType.h"
+#include "../Chess/Position.h"
+#include "../Utils/MappedFile.h"
+
+/*
+ * Endgame tablebases for a lone king against a king and up to two pieces, such as KPK, KRK, KQK and KBNK, written by
+ * `ChessGame tbgen` and mapped read-only.
+ *
+ * Positions are seen from the side with the pieces, called white here, with the ranks flipped when it is black. The
+ * index is side to move, white king, black king, then each piece's square in canonical order. The white king is
+ * mirrored onto files a-d, which halves every table.
+ *
+ * Each table is two files of a 16-byte header followed by bit-packed entries:
+ *  - NAME.wdl  2 bits per position: draw, win or loss for the side to move, or illegal
+ *  - NAME.dtm  plies to mate, 0 for draws, in as few bits as the longest mate needs
+ */
+
+// Pieces beside the kings
+constexpr int TB_MAX_PIECES = 2;
+
+enum TablebaseWdl : uint8_t { TB_DRAW = 0, TB_WIN = 1, TB_LOSS = 2, TB_ILLEGAL = 3 };
+
+// Queens first and pawns last, the order pieces are indexed in
+constexpr PieceType TB_PIECE_ORDER[5] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+
+// The pieces of the side that has them, in canonical order
+struct TablebaseMaterial {
+    int count = 0;
+    PieceType pieces[TB_MAX_PIECES] = {EMPTY, EMPTY};
+
+    // "KBNK"
+    std::string getName() const;
+
+    // A lone minor piece cannot mate, those endings need no table
+    bool isDrawn() const { return count == 0 || (count == 1 && (pieces[0] == BISHOP || pieces[0] == KNIGHT)); }
+
+    bool operator==(const TablebaseMaterial& other) const {
+        return count == other.count && pieces[0] == other.pieces[0] && pieces[1] == other.pieces[1];
+    }
+};
+
+struct TablebaseHeader {
+    char magic[4];  // "TBWL" or "TBDM"
+    uint8_t version;
+    uint8_t bits;
+    uint8_t count;
+    uint8_t pieces[TB_MAX_PIECES];
+    uint8_t reserved[7];
+};
+static_assert(sizeof(TablebaseHeader) == 16);
+
+constexpr uint8_t TB_VERSION = 1;
+
+inline size_t tablebaseSize(int count) { return size_t{2 * 32 * 64} << (6 * count); }
+
+// Squares in canonical piece order, white to move in the first half
+inline size_t tablebaseIndex(bool whiteToMove, int whiteKing, int blackKing, const int* squares, int count) {
+    int mirror = (whiteKing & 7) >= 4 ? 7 : 0;
+    whiteKing ^= mirror;
+
+    size_t index = whiteToMove ? 0 : 1;
+    index = index * 32 + (whiteKing >> 3) * 4 + (whiteKing & 7);
+    index = index * 64 + (blackKing ^ mirror);
+    for (int i = 0; i < count; ++i) index = index * 64 + (squares[i] ^ mirror);
+    return index;
+}
+
+class Tablebases {
+public:
+    // Maps every table in the directory, returns how many were loaded
+    int load(const std::string& directory);
+
+    // Men on the board, kings included, up to which positions may be covered, 0 with no tables loaded
+    int getMaxMen() const { return maxMen; }
+
+    // Win, draw or loss for the side to move, and with plies the distance to mate. False if no table covers the
+    // position, or it has castling rights.
+    bool probe(const Position& position, TablebaseWdl& wdl, int* plies = nullptr) const;
+
+private:
+    struct Table {
+        TablebaseMaterial material;
+        MappedFile wdl;
+        MappedFile dtm;
+        int dtmBits = 0;
+    };
+
+    std::vector<std::unique_ptr<Table>> tables;
+    int maxMen = 0;
+
+    static bool openFile(MappedFile& file, const std::string& path, const char* magic, TablebaseMaterial& material,
+                         int& bits);
+    static int readEntry(const MappedFile& file, int bits, size_t index);
+};
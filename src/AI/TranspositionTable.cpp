@@ -0,0 +1,78 @@
+#include "TranspositionTable.h"
+
+#include <climits>
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    // Largest power of two number of buckets that fits, at least one
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= (megabytes << 20)) count *= 2;
+
+    buckets = std::make_unique<Bucket[]>(count);
+    mask = count - 1;
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; i <= mask; ++i) {
+        for (Entry& entry : buckets[i].entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+uint64_t TranspositionTable::pack(Move move, int score, int depth, Bound bound, int generation) {
+    return move.raw() | (static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16) |
+           (static_cast<uint64_t>(depth & 0xFF) << 32) | (static_cast<uint64_t>(bound) << 40) |
+           (static_cast<uint64_t>(generation) << 42);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& data) const {
+    for (const Entry& entry : buckets[key & mask].entries) {
+        uint64_t packed = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ packed) != key || boundOf(packed) == BOUND_NONE) continue;
+
+        data.move = Move(static_cast<uint16_t>(packed));
+        data.score = static_cast<int16_t>(packed >> 16);
+        data.depth = depthOf(packed);
+        data.bound = boundOf(packed);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, Bound bound) {
+    Bucket& bucket = buckets[key & mask];
+
+    Entry* replace = nullptr;
+    int worstValue = INT_MAX;
+
+    for (Entry& entry : bucket.entries) {
+        uint64_t packed = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ packed) == key && boundOf(packed) != BOUND_NONE) {
+            // A shallower result of this search would throw away deeper work, unless it is exact
+            if (bound != BOUND_EXACT && generationOf(packed) == generation && depth + 2 < depthOf(packed)) return;
+
+            // Keep the old best move when this search found none, it still orders the next visit
+            if (move == Move::none()) move = Move(static_cast<uint16_t>(packed));
+            replace = &entry;
+            break;
+        }
+
+        // Each generation of age weighs like eight plies of depth, empty slots go first
+        int age = (generation - generationOf(packed)) & GENERATION_MASK;
+        int value = boundOf(packed) == BOUND_NONE ? INT_MIN : depthOf(packed) - 8 * age;
+        if (value < worstValue) {
+            worstValue = value;
+            replace = &entry;
+        }
+    }
+
+    uint64_t packed = pack(move, score, depth, bound, generation);
+    replace->check.store(key ^ packed, std::memory_order_relaxed);
+    replace->data.store(packed, std::memory_order_relaxed);
+}
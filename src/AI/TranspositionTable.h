@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "../Chess/Move.h"
+
+// What a stored score says about the true score of the position
+enum Bound : uint8_t { BOUND_NONE = 0, BOUND_UPPER = 1, BOUND_LOWER = 2, BOUND_EXACT = 3 };
+
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+/*
+ * Fixed-size hash table of search results, shared by all search threads without locks.
+ *
+ * Each entry is two 64-bit words, the packed data and the key XORed with it. A write torn by another
+ * thread fails the key check on the next probe and reads as a miss. Four entries share one cache line,
+ * a store replaces the same position if present, otherwise the shallowest and oldest entry.
+ */
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Starts a new generation, entries from earlier searches become the first to be replaced
+    void newSearch() { generation = (generation + 1) & GENERATION_MASK; }
+    void clear();
+
+    bool probe(uint64_t key, TTData& data) const;
+    void store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+    size_t getSizeInBytes() const { return (mask + 1) * sizeof(Bucket); }
+
+private:
+    static constexpr int ENTRIES_PER_BUCKET = 4;
+    static constexpr int GENERATION_MASK = 63;
+
+    // data layout: move 0-15, score 16-31, depth 32-39, bound 40-41, generation 42-47
+    static uint64_t pack(Move move, int score, int depth, Bound bound, int generation);
+    static int depthOf(uint64_t data) { return static_cast<int>((data >> 32) & 0xFF); }
+    static Bound boundOf(uint64_t data) { return static_cast<Bound>((data >> 40) & 3); }
+    static int generationOf(uint64_t data) { return static_cast<int>((data >> 42) & GENERATION_MASK); }
+
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[ENTRIES_PER_BUCKET];
+    };
+
+    static_assert(sizeof(Bucket) == 64, "a bucket must fill exactly one cache line");
+
+    std::unique_ptr<Bucket[]> buckets;
+    uint64_t mask;
+    int generation = 0;
+};
@@ -5,6 +5,7 @@
 
 #include "../Utils/bits.h"
 #include "ChessBoard.h"
+#include "Magics.h"
 
 enum Direction { N, S, E, W, NE, NW, SE, SW };
 
@@ -13,6 +14,9 @@ struct AttackTables {
     std::array<uint64_t, 64> king;
     std::array<std::array<uint64_t, 64>, 2> pawn;
     std::array<std::array<uint64_t, 8>, 64> rays;
+    // squares strictly between two aligned squares, and the full line through them (0 if not aligned)
+    std::array<std::array<uint64_t, 64>, 64> between;
+    std::array<std::array<uint64_t, 64>, 64> line;
 };
 
 constexpr bool onBoard(int x, int y) { return x >= 0 && x < 8 && y >= 0 && y < 8; }
@@ -75,6 +79,22 @@ constexpr AttackTables genAttackTables() {
         gen(-1, 1, SW);
     }
 
+    // Between and line tables, built from the finished rays
+    constexpr Direction opposite[8] = {S, N, W, E, SW, SE, NW, NE};
+
+    for (int a = 0; a < 64; ++a) {
+        for (int dir = 0; dir < 8; ++dir) {
+            uint64_t ray = t.rays[a][dir];
+            uint64_t fullLine = ray | t.rays[a][opposite[dir]] | (1ULL << a);
+
+            for (int b = 0; b < 64; ++b) {
+                if (!(ray & (1ULL << b))) continue;
+                t.between[a][b] = ray & ~t.rays[b][dir] & ~(1ULL << b);
+                t.line[a][b] = fullLine;
+            }
+        }
+    }
+
     return t;
 }
 
@@ -93,14 +113,102 @@ inline uint64_t getRayMoves(int sq, Direction dir, uint64_t occupied) {
     return ray ^ ATTACK_TABLES.rays[blockerSq][dir];
 }
 
-inline uint64_t rookMoves(int sq, uint64_t occupied) {
+// Ray scanning, only used to build the slider tables and as a benchmark baseline
+inline uint64_t rookRayMoves(int sq, uint64_t occupied) {
     return getRayMoves(sq, N, occupied) | getRayMoves(sq, S, occupied) | getRayMoves(sq, E, occupied) |
            getRayMoves(sq, W, occupied);
 }
 
-inline uint64_t bishopMoves(int sq, uint64_t occupied) {
+inline uint64_t bishopRayMoves(int sq, uint64_t occupied) {
     return getRayMoves(sq, NE, occupied) | getRayMoves(sq, NW, occupied) | getRayMoves(sq, SE, occupied) |
            getRayMoves(sq, SW, occupied);
 }
 
-inline uint64_t queenMoves(int sq, uint64_t occupied) { return bishopMoves(sq, occupied) | rookMoves(sq, occupied); }
\ No newline at end of file
+// The indexing never changes after startup, so the branch is always predicted
+inline uint64_t rookMoves(int sq, uint64_t occupied) {
+    return SLIDER_ATTACKS.indexing == SliderIndexing::PEXT
+               ? rookAttacks<SliderIndexing::PEXT>(SLIDER_ATTACKS, sq, occupied)
+               : rookAttacks<SliderIndexing::MAGIC>(SLIDER_ATTACKS, sq, occupied);
+}
+
+inline uint64_t bishopMoves(int sq, uint64_t occupied) {
+    return SLIDER_ATTACKS.indexing == SliderIndexing::PEXT
+               ? bishopAttacks<SliderIndexing::PEXT>(SLIDER_ATTACKS, sq, occupied)
+               : bishopAttacks<SliderIndexing::MAGIC>(SLIDER_ATTACKS, sq, occupied);
+}
+
+inline uint64_t queenMoves(int sq, uint64_t occupied) { return bishopMoves(sq, occupied) | rookMoves(sq, occupied); }
+
+// Squares a piece attacks, own pieces included, pawns only attack diagonally
+inline uint64_t pieceAttacks(PieceType pieceType, bool white, int sq, uint64_t occupied) {
+    switch (pieceType) {
+        case PAWN:
+            return ATTACK_TABLES.pawn[white][sq];
+        case KNIGHT:
+            return ATTACK_TABLES.knight[sq];
+        case BISHOP:
+            return bishopMoves(sq, occupied);
+        case ROOK:
+            return rookMoves(sq, occupied);
+        case QUEEN:
+            return queenMoves(sq, occupied);
+        case KING:
+            return ATTACK_TABLES.king[sq];
+        default:
+            return 0;
+    }
+}
+
+// Single and double pushes onto empty squares, white moves north
+inline uint64_t pawnPushes(int from, bool white, uint64_t occ) {
+    uint64_t fromBB = 1ULL << from;
+    uint64_t moves = 0;
+
+    if (white) {
+        uint64_t one = fromBB >> 8;
+        if (!(one & occ)) {
+            moves |= one;
+
+            if ((from >> 3) == 6) {
+                uint64_t two = fromBB >> 16;
+                if (!(two & occ)) moves |= two;
+            }
+        }
+    } else {
+        uint64_t one = fromBB << 8;
+        if (!(one & occ)) {
+            moves |= one;
+
+            if ((from >> 3) == 1) {
+                uint64_t two = fromBB << 16;
+                if (!(two & occ)) moves |= two;
+            }
+        }
+    }
+
+    return moves;
+}
+
+constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+constexpr uint64_t FILE_H = FILE_A << 7;
+
+// Set-wise pawn moves, for every pawn of one side at once
+inline uint64_t pawnSinglePushes(uint64_t pawns, bool white, uint64_t empty) {
+    return (white ? pawns >> 8 : pawns << 8) & empty;
+}
+
+inline uint64_t pawnDoublePushes(uint64_t pawns, bool white, uint64_t empty) {
+    uint64_t thirdRank = white ? 0xFFULL << 40 : 0xFFULL << 16;
+    return pawnSinglePushes(pawnSinglePushes(pawns, white, empty) & thirdRank, white, empty);
+}
+
+// Captures towards the a-file and towards the h-file
+inline uint64_t pawnAttacksWest(uint64_t pawns, bool white) {
+    pawns &= ~FILE_A;
+    return white ? pawns >> 9 : pawns << 7;
+}
+
+inline uint64_t pawnAttacksEast(uint64_t pawns, bool white) {
+    pawns &= ~FILE_H;
+    return white ? pawns >> 7 : pawns << 9;
+}
@@ -1,56 +1,19 @@
 #include "ChessBoard.h"
 
-#include <cassert>
-#include <cmath>
 #include <cstdint>
-#include <random>
 
 #include "./AttackTables.h"
-/*
- * Bitboard usage:
- *  - index = x + y * 8   get the index
- *  - x = idx & 7         get the x (file)
- *  - y = idx >> 3        get the y (rank)
- *  - 1ULL << index       sets a bit at the square index
- *  - (board & mask)      checks if a square is occupied
- *  - board |= mask       adds a piece
- *  - board &= ~mask      removes a piece
- *
- * Bit shifts are used to generate moves.
- *
- *  - North:              >> 8
- *  - South:              << 8
- *  - East:               << 1
- *  - West:               >> 1
- */
 
-ChessBoard::ChessBoard(ChessBoard&& other) noexcept { copyFrom(other); }
+ChessBoard::ChessBoard(ChessBoard&& other) noexcept : position(other.position) {}
 
 ChessBoard& ChessBoard::operator=(ChessBoard&& other) noexcept {
     if (this != &other) {
-        copyFrom(other);
+        position = other.position;
     }
     return *this;
 }
 
-ChessBoard ChessBoard::clone() const {
-    ChessBoard copy;
-    copy.copyFrom(*this);
-    return copy;
-}
-
-void ChessBoard::copyFrom(const ChessBoard& other) {
-    whitePieces = other.whitePieces;
-    blackPieces = other.blackPieces;
-    for (int i = 0; i < 6; ++i) pieces[i] = other.pieces[i];
-    zobristSideToMove = other.zobristSideToMove;
-
-    for (int i = 0; i < 12; ++i) {
-        for (int j = 0; j < 64; ++j) {
-            zobristTable[i][j] = other.zobristTable[i][j];
-        }
-    }
-}
+ChessBoard ChessBoard::clone() const { return ChessBoard(position); }
 
 void ChessBoard::resetBoard() {
     emptyBoard();
@@ -87,192 +50,62 @@ void ChessBoard::resetBoard() {
     setPiece(4, 0, KING, BLACK);
     setPiece(4, 7, KING, WHITE);
 
+    position.setWhiteToMove(WHITE);
+    position.setCastlingRights(ALL_CASTLING);
     gameOver = false;
 }
 
-void ChessBoard::emptyBoard() {
-    whitePieces = 0;
-    blackPieces = 0;
-    pieces[PAWN] = 0;
-    pieces[ROOK] = 0;
-    pieces[KNIGHT] = 0;
-    pieces[BISHOP] = 0;
-    pieces[QUEEN] = 0;
-    pieces[KING] = 0;
-}
+void ChessBoard::emptyBoard() { position.clear(); }
 
-uint64_t ChessBoard::getColorBitboard(bool isWhite) const { return isWhite ? whitePieces : blackPieces; }
+uint64_t ChessBoard::getColorBitboard(bool isWhite) const { return position.getColorBitboard(isWhite); }
 
 uint64_t ChessBoard::getPieceBitboard(PieceType pieceType, bool isWhite) const {
-    return pieces[pieceType] & getColorBitboard(isWhite);
+    return position.getPieceBitboard(pieceType, isWhite);
 }
 
 char ChessBoard::getPieceSymbol(int x, int y) const { return pieceTypeToSymbol(getPieceTypeAt(x, y)); }
 
 void ChessBoard::setPiece(int x, int y, const PieceType pieceType, bool isWhite) {
-    uint64_t piece = 1ULL << (x + y * 8);
-    if (isWhite) {
-        whitePieces |= piece;
-    } else {
-        blackPieces |= piece;
-    }
-    pieces[pieceType] |= piece;
+    position.setPiece(x + y * 8, pieceType, isWhite);
 }
 
 void ChessBoard::removePiece(int x, int y, const PieceType pieceType, bool isWhite) {
-    uint64_t piece = 1ULL << (x + y * 8);
-    if (isWhite) {
-        whitePieces &= ~piece;
-    } else {
-        blackPieces &= ~piece;
+    if (isPieceAt(x, y, pieceType) && isPieceAt(x, y, isWhite)) {
+        position.removePiece(x + y * 8);
     }
-    pieces[pieceType] &= ~piece;
 }
 
 bool ChessBoard::isPieceAt(int x, int y) const {
     if (!onBoard(x, y)) return false;
-    uint64_t piece = 1ULL << (x + y * 8);
-    return (whitePieces & piece) || (blackPieces & piece);
+    return position.getPieceTypeAt(x + y * 8) != EMPTY;
 }
 
 bool ChessBoard::isPieceAt(int x, int y, bool isWhite) const {
     if (!onBoard(x, y)) return false;
-    uint64_t piece = 1ULL << (x + y * 8);
-    return isWhite ? (whitePieces & piece) : (blackPieces & piece);
+    return position.getColorBitboard(isWhite) & (1ULL << (x + y * 8));
 }
 
 bool ChessBoard::isPieceAt(int x, int y, const PieceType pieceType) const {
     if (!onBoard(x, y)) return false;
-    uint64_t piece = 1ULL << (x + y * 8);
-    return pieces[pieceType] & piece;
+    return position.getPieceTypeAt(x + y * 8) == pieceType;
 }
 
-bool ChessBoard::getPieceColor(int x, int y) const {
-    uint64_t piece = 1ULL << (x + y * 8);
-    return (whitePieces & piece) != 0;
-}
+bool ChessBoard::getPieceColor(int x, int y) const { return position.isWhiteAt(x + y * 8); }
 
 bool ChessBoard::removePieceAt(int x, int y) {
-    if (!onBoard(x, y)) return false;
-    if (isPieceAt(x, y)) {
-        uint64_t piece = 1ULL << (x + y * 8);
-        whitePieces &= ~piece;
-        blackPieces &= ~piece;
-        for (int i = 0; i < 6; ++i) {
-            pieces[i] &= ~piece;
-        }
-        return true;
-    }
-    return false;
-}
-
-PieceType ChessBoard::getPieceTypeAt(int x, int y) const {
-    if (!onBoard(x, y)) return EMPTY;
-
-    if (isPieceAt(x, y, PAWN)) return PAWN;
-    if (isPieceAt(x, y, ROOK)) return ROOK;
-    if (isPieceAt(x, y, KNIGHT)) return KNIGHT;
-    if (isPieceAt(x, y, BISHOP)) return BISHOP;
-    if (isPieceAt(x, y, QUEEN)) return QUEEN;
-    if (isPieceAt(x, y, KING)) return KING;
-    return EMPTY;
-}
-
-bool ChessBoard::movePiece(int x, int y, int newX, int newY) {
-    if (!onBoard(x, y) || !onBoard(newX, newY)) return false;
     if (!isPieceAt(x, y)) return false;
-
-    auto piece = getPieceTypeAt(x, y);
-
-    // Use getValidMoves to validate
-    uint64_t valid = getValidMoves(x, y);
-    uint64_t target = 1ULL << (newX + newY * 8);
-
-    if (!(valid & target)) return false;
-
-    // Make move
-    removePieceAt(newX, newY);
-    setPiece(newX, newY, piece, getPieceColor(x, y));
-    removePieceAt(x, y);
-
+    position.removePiece(x + y * 8);
     return true;
 }
 
-void ChessBoard::undoMove(int x, int y, int newX, int newY, const PieceType capturedPiece) {
-    if (!onBoard(x, y) || !onBoard(newX, newY)) return;
-
-    bool color = getPieceColor(newX, newY);
-    auto piece = getPieceTypeAt(newX, newY);
-
-    setPiece(x, y, piece, color);
-    removePieceAt(newX, newY);
-
-    if (capturedPiece != EMPTY) {
-        setPiece(newX, newY, capturedPiece, !color);
-    }
-}
-
-inline uint64_t pawnPushes(int from, bool white, uint64_t occ) {
-    uint64_t fromBB = 1ULL << from;
-    uint64_t moves = 0;
-
-    if (white) {
-        uint64_t one = fromBB >> 8;
-        if (!(one & occ)) {
-            moves |= one;
-
-            if ((from >> 3) == 6) {
-                uint64_t two = fromBB >> 16;
-                if (!(two & occ)) moves |= two;
-            }
-        }
-    } else {
-        uint64_t one = fromBB << 8;
-        if (!(one & occ)) {
-            moves |= one;
-
-            if ((from >> 3) == 1) {
-                uint64_t two = fromBB << 16;
-                if (!(two & occ)) moves |= two;
-            }
-        }
-    }
-
-    return moves;
+PieceType ChessBoard::getPieceTypeAt(int x, int y) const {
+    if (!onBoard(x, y)) return EMPTY;
+    return position.getPieceTypeAt(x + y * 8);
 }
 
 uint64_t ChessBoard::getValidMoves(int x, int y) const {
-    if (!onBoard(x, y) || !isPieceAt(x, y)) return 0;
-
-    bool white = getPieceColor(x, y);
-    uint64_t own = white ? whitePieces : blackPieces;
-    uint64_t occ = whitePieces | blackPieces;
-    uint64_t from = x + (y << 3);
-
-    switch (getPieceTypeAt(x, y)) {
-        case KNIGHT:
-            return ATTACK_TABLES.knight[from] & ~own;
-
-        case KING:
-            return ATTACK_TABLES.king[from] & ~own;
-
-        case PAWN: {
-            uint64_t enemy = occ ^ own;
-            return pawnPushes(from, white, occ) | (ATTACK_TABLES.pawn[white][from] & enemy);
-        }
-
-        case ROOK:
-            return rookMoves(from, occ) & ~own;
-
-        case BISHOP:
-            return bishopMoves(from, occ) & ~own;
-
-        case QUEEN:
-            return (rookMoves(from, occ) | bishopMoves(from, occ)) & ~own;
-
-        default:
-            return 0;
-    }
+    if (!onBoard(x, y)) return 0;
+    return position.getValidMoves(x + y * 8);
 }
 
 bool ChessBoard::isValidMove(int x, int y, int newX, int newY) const {
@@ -288,37 +121,3 @@ bool ChessBoard::isValidAttack(int x, int y, int newX, int newY) const {
 
     return isValidMove(x, y, newX, newY) && (getPieceColor(x, y) != getPieceColor(newX, newY));
 }
-
-void ChessBoard::initializeZobristTable() {
-    std::mt19937_64 rng(123456);  // Fixed seed for reproducibility
-    std::uniform_int_distribution<uint64_t> dist(0, std::numeric_limits<uint64_t>::max());
-
-    for (int piece = 0; piece < 12; ++piece) {
-        for (int square = 0; square < 64; ++square) {
-            zobristTable[piece][square] = dist(rng);
-        }
-    }
-
-    zobristSideToMove = dist(rng);
-}
-
-uint64_t ChessBoard::getBoardHash(bool isWhiteTurn) const {
-    uint64_t hash = 0;
-
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            PieceType piece = getPieceTypeAt(x, y);
-            if (piece != EMPTY) {
-                int pieceIndex = getPieceColor(x, y) == WHITE ? piece : piece + 6;
-                int squareIndex = y * 8 + x;
-                hash ^= zobristTable[pieceIndex][squareIndex];
-            }
-        }
-    }
-
-    if (!isWhiteTurn) {
-        hash ^= zobristSideToMove;
-    }
-
-    return hash;
-}
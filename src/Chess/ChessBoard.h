@@ -1,16 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cassert>
 #include <cstdint>
 #include <mutex>
 
 #include "PieceType.h"
+#include "Position.h"
 
 class ChessBoard {
 public:
-    ChessBoard() {
-        resetBoard();
-        // initializeZobristTable();
-    }
+    ChessBoard() { resetBoard(); }
+    explicit ChessBoard(const Position& position) : position(position) {}
 
     std::mutex mtx;
 
@@ -28,13 +29,14 @@ public:
     // board functions
     void resetBoard();
     void emptyBoard();
-    uint64_t getBoard() const { return whitePieces | blackPieces; }
+    const Position& getPosition() const { return position; }
+    uint64_t getBoard() const { return position.getOccupied(); }
     uint64_t getColorBitboard(bool isWhite) const;
     uint64_t getPieceBitboard(PieceType pieceType, bool isWhite) const;
+    bool isWhiteToMove() const { return position.isWhiteToMove(); }
 
-    // Zobrist hashing
-    uint64_t getBoardHash(bool isWhiteTurn) const;
-    void initializeZobristTable();
+    // Zobrist hashing, kept up to date by every piece change
+    uint64_t getBoardHash() const { return position.getHash(); }
 
     // piece functions
     char getPieceSymbol(int x, int y) const;
@@ -48,20 +50,40 @@ public:
     bool getPieceColor(int x, int y) const;
     bool removePieceAt(int x, int y);
     PieceType getPieceTypeAt(int x, int y) const;
-    bool movePiece(int x, int y, int newX, int newY);
-    void undoMove(int x, int y, int newX, int newY, const PieceType capturedPiece);
+    PieceType getPieceTypeAt(int square) const { return position.getPieceTypeAt(square); }
+    // Legal moves only, castling is the king moving two squares, pawns promote to a queen unless flagged
+    bool movePiece(Move move) { return position.movePiece(move); }
     uint64_t getValidMoves(int x, int y) const;
     bool isValidMove(int x, int y, int newX, int newY) const;
     bool isValidAttack(int x, int y, int newX, int newY) const;
 
+    // Unchecked search moves, makeMove pushes the state unmakeMove pops to restore
+    static constexpr int MAX_UNDO = 256;
+    void makeMove(Move move) {
+        assert(undoCount < MAX_UNDO && "undo stack overflow");
+        position.makeMove(move, undoStack[undoCount++]);
+    }
+    void unmakeMove() {
+        assert(undoCount > 0 && "unmakeMove without makeMove");
+        position.unmakeMove(undoStack[--undoCount]);
+    }
+    void makeNullMove() {
+        assert(undoCount < MAX_UNDO && "undo stack overflow");
+        position.makeNullMove(undoStack[undoCount++]);
+    }
+    void unmakeNullMove() {
+        assert(undoCount > 0 && "unmakeNullMove without makeNullMove");
+        position.unmakeNullMove(undoStack[--undoCount]);
+    }
+
+    // debug check that the mailbox and hash match the bitboards
+    bool isConsistent() const { return position.isConsistent(); }
+
 private:
     bool gameOver = false;
 
-    uint64_t whitePieces = 0;
-    uint64_t blackPieces = 0;
-    uint64_t pieces[6] = {0, 0, 0, 0, 0, 0};
+    Position position;
 
-    uint64_t zobristTable[12][64];
-    uint64_t zobristSideToMove;
-    void copyFrom(const ChessBoard& other);
-};
\ No newline at end of file
+    std::array<UndoState, MAX_UNDO> undoStack;
+    int undoCount = 0;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "../Utils/bits.h"
+
+/*
+ * Slider attacks by table lookup.
+ *
+ * Every square owns a block of 2^n attack sets, n being the number of relevant
+ * occupancy bits (the empty-board rays minus the board edge). The block is
+ * addressed either by a magic multiply or, when the CPU has a fast pext, by pext:
+ *
+ *  - magic:  ((occupied & mask) * magic) >> (64 - n)
+ *  - pext:   pext(occupied, mask)
+ *
+ * Both layouts have the same size, only the order inside a block differs.
+ */
+
+enum class SliderIndexing { MAGIC, PEXT };
+
+inline SliderIndexing bestSliderIndexing() {
+    return CPU_FEATURES.fastPext ? SliderIndexing::PEXT : SliderIndexing::MAGIC;
+}
+
+inline bool sliderIndexingSupported(SliderIndexing indexing) {
+    return indexing == SliderIndexing::MAGIC || CPU_FEATURES.bmi2;
+}
+
+constexpr int ROOK_TABLE_SIZE = 102400;
+constexpr int BISHOP_TABLE_SIZE = 5248;
+
+struct SliderMagic {
+    uint64_t mask;
+    uint64_t magic;
+    uint32_t offset;
+    uint32_t shift;
+};
+
+struct SliderAttacks {
+    explicit SliderAttacks(SliderIndexing indexing);
+
+    SliderIndexing indexing;
+    std::array<SliderMagic, 64> rook;
+    std::array<SliderMagic, 64> bishop;
+    std::array<uint64_t, ROOK_TABLE_SIZE> rookTable;
+    std::array<uint64_t, BISHOP_TABLE_SIZE> bishopTable;
+};
+
+template <SliderIndexing Indexing>
+inline uint32_t sliderIndex(const SliderMagic& m, uint64_t occupied) {
+    if constexpr (Indexing == SliderIndexing::PEXT) {
+        return m.offset + static_cast<uint32_t>(pext(occupied, m.mask));
+    }
+    return m.offset + static_cast<uint32_t>(((occupied & m.mask) * m.magic) >> m.shift);
+}
+
+template <SliderIndexing Indexing>
+inline uint64_t rookAttacks(const SliderAttacks& t, int sq, uint64_t occupied) {
+    return t.rookTable[sliderIndex<Indexing>(t.rook[sq], occupied)];
+}
+
+template <SliderIndexing Indexing>
+inline uint64_t bishopAttacks(const SliderAttacks& t, int sq, uint64_t occupied) {
+    return t.bishopTable[sliderIndex<Indexing>(t.bishop[sq], occupied)];
+}
+
+// Built once at startup for the running CPU, roughly 850 KB
+inline const SliderAttacks SLIDER_ATTACKS(bestSliderIndexing());
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+#include "PieceType.h"
+
+// Moves that do more than take a piece from one square to another
+enum MoveFlag : uint8_t { NORMAL_MOVE = 0, PROMOTION = 1, EN_PASSANT = 2, CASTLING = 3 };
+
+/*
+ * A move packed into 16 bits:
+ *  - bits 0-5    from square
+ *  - bits 6-11   to square
+ *  - bits 12-13  MoveFlag
+ *  - bits 14-15  promotion piece, ROOK to QUEEN stored as 0-3
+ *
+ * Trivial so move buffers stay uninitialized. The null move (a8a8) is never legal.
+ */
+class Move {
+public:
+    Move() = default;
+    constexpr explicit Move(uint16_t data) : data(data) {}
+    constexpr Move(int from, int to, MoveFlag flag = NORMAL_MOVE, PieceType promotion = EMPTY)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flag << 12) |
+                                     (flag == PROMOTION ? (promotion - ROOK) << 14 : 0))) {}
+
+    static constexpr Move none() { return Move(uint16_t{0}); }
+
+    constexpr int from() const { return data & 63; }
+    constexpr int to() const { return (data >> 6) & 63; }
+    constexpr MoveFlag flag() const { return static_cast<MoveFlag>((data >> 12) & 3); }
+
+    // Only meaningful for PROMOTION moves
+    constexpr PieceType promotion() const { return static_cast<PieceType>((data >> 14) + ROOK); }
+
+    constexpr uint16_t raw() const { return data; }
+    constexpr bool operator==(Move other) const { return data == other.data; }
+    constexpr bool operator!=(Move other) const { return data != other.data; }
+
+private:
+    uint16_t data;
+};
+
+static_assert(sizeof(Move) == 2, "Move must stay packed");
+
+// Coordinate notation, "e2e4" or "e7e8q" for promotions
+inline std::string moveToString(Move move) {
+    int from = move.from();
+    int to = move.to();
+    std::string text = {static_cast<char>('a' + (from & 7)), static_cast<char>('8' - (from >> 3)),
+                        static_cast<char>('a' + (to & 7)), static_cast<char>('8' - (to >> 3))};
+    if (move.flag() == PROMOTION) text += static_cast<char>(tolower(pieceTypeToSymbol(move.promotion())));
+    return text;
+}
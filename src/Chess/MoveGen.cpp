@@ -0,0 +1,270 @@
+#include "MoveGen.h"
+
+#include <cstdint>
+
+#include "../Utils/bits.h"
+#include "AttackTables.h"
+
+constexpr uint64_t PROMOTION_RANKS = 0xFFULL | (0xFFULL << 56);
+
+CheckInfo::CheckInfo(const Position& position) {
+    bool isWhite = position.isWhiteToMove();
+    uint64_t own = position.getColorBitboard(isWhite);
+    uint64_t enemy = position.getColorBitboard(!isWhite);
+    uint64_t occupied = own | enemy;
+
+    king = position.getKingSquare(isWhite);
+#if defined(ATTACK_MAPS)
+    checkers = position.isSquareAttacked(king, !isWhite) ? position.attackersTo(king, occupied) & enemy : 0;
+#else
+    checkers = position.attackersTo(king, occupied) & enemy;
+#endif
+
+    // With one checker every other move must capture it or block the ray
+    checkMask = checkers ? ATTACK_TABLES.between[king][ctz(checkers)] | checkers : ~0ULL;
+
+    // Enemy sliders that see the king through exactly one of our pieces pin it to their line
+    pinned = 0;
+    uint64_t rookLike = position.getPieceBitboard(ROOK, !isWhite) | position.getPieceBitboard(QUEEN, !isWhite);
+    uint64_t bishopLike = position.getPieceBitboard(BISHOP, !isWhite) | position.getPieceBitboard(QUEEN, !isWhite);
+    uint64_t snipers = (rookMoves(king, enemy) & rookLike) | (bishopMoves(king, enemy) & bishopLike);
+
+    for (; snipers; snipers = clearLsb(snipers)) {
+        uint64_t blockers = ATTACK_TABLES.between[king][ctz(snipers)] & occupied;
+        if (blockers && !clearLsb(blockers) && (blockers & own)) pinned |= blockers;
+    }
+}
+
+// Legal targets of a non-king piece, a pinned piece may only slide along the line through the king and its pinner
+static inline uint64_t pieceTargets(const Position& position, const CheckInfo& info, int from, PieceType piece,
+                                    uint64_t own, uint64_t occupied) {
+    bool isWhite = position.isWhiteToMove();
+    uint64_t allowed = (info.pinned >> from) & 1 ? info.checkMask & ATTACK_TABLES.line[info.king][from]
+                                                 : info.checkMask;
+
+    switch (piece) {
+        case PAWN:
+            return (pawnPushes(from, isWhite, occupied) | (ATTACK_TABLES.pawn[isWhite][from] & occupied & ~own)) &
+                   allowed;
+        case KNIGHT:
+            return ATTACK_TABLES.knight[from] & ~own & allowed;
+        case BISHOP:
+            return bishopMoves(from, occupied) & ~own & allowed;
+        case ROOK:
+            return rookMoves(from, occupied) & ~own & allowed;
+        case QUEEN:
+            return queenMoves(from, occupied) & ~own & allowed;
+        default:
+            return 0;
+    }
+}
+
+#if defined(ATTACK_MAPS)
+// King steps within the mask. The attack map has the king in place, so squares behind it on a checking slider's ray
+// look safe; those come from the slider checkers with the king lifted.
+static uint64_t kingTargets(const Position& position, const CheckInfo& info, uint64_t mask) {
+    bool isWhite = position.isWhiteToMove();
+    uint64_t unsafe = position.getAttackedSquares(!isWhite);
+
+    uint64_t withoutKing = position.getOccupied() ^ (1ULL << info.king);
+    uint64_t sliders = info.checkers & ~(position.getPieceBitboard(PAWN, !isWhite) |
+                                         position.getPieceBitboard(KNIGHT, !isWhite));
+    for (; sliders; sliders = clearLsb(sliders)) {
+        int square = ctz(sliders);
+        unsafe |= pieceAttacks(position.getPieceTypeAt(square), !isWhite, square, withoutKing);
+    }
+
+    return ATTACK_TABLES.king[info.king] & ~position.getColorBitboard(isWhite) & ~unsafe & mask;
+}
+#else
+// King steps within the mask, with the king lifted so it cannot hide behind itself on a slider's ray
+static uint64_t kingTargets(const Position& position, const CheckInfo& info, uint64_t mask) {
+    bool isWhite = position.isWhiteToMove();
+    uint64_t withoutKing = position.getOccupied() ^ (1ULL << info.king);
+
+    uint64_t safe = 0;
+    for (uint64_t targets = ATTACK_TABLES.king[info.king] & ~position.getColorBitboard(isWhite) & mask; targets;
+         targets = clearLsb(targets)) {
+        int to = ctz(targets);
+        if (!position.isSquareAttacked(to, !isWhite, withoutKing)) safe |= 1ULL << to;
+    }
+    return safe;
+}
+#endif
+
+static void addMoves(int from, uint64_t targets, Move*& moves) {
+    for (; targets; targets = clearLsb(targets)) {
+        *moves++ = Move(from, ctz(targets));
+    }
+}
+
+// Set-wise pawn targets, every one of them reached from the same offset
+static void addPawnMoves(uint64_t targets, int offset, Move*& moves) {
+    for (uint64_t plain = targets & ~PROMOTION_RANKS; plain; plain = clearLsb(plain)) {
+        int to = ctz(plain);
+        *moves++ = Move(to + offset, to);
+    }
+
+    for (uint64_t promotions = targets & PROMOTION_RANKS; promotions; promotions = clearLsb(promotions)) {
+        int to = ctz(promotions);
+        for (PieceType piece : {QUEEN, ROOK, BISHOP, KNIGHT}) {
+            *moves++ = Move(to + offset, to, PROMOTION, piece);
+        }
+    }
+}
+
+static void addEnPassant(const Position& position, int king, Move*& moves) {
+    int target = position.getEnPassantSquare();
+    if (target == NO_SQUARE) return;
+
+    bool isWhite = position.isWhiteToMove();
+    uint64_t enemy = position.getColorBitboard(!isWhite);
+    int capturedSquare = isWhite ? target + 8 : target - 8;
+    uint64_t capturedBB = 1ULL << capturedSquare;
+
+    // Two pawns leave the rank at once, so pin masks miss the horizontal case; replay the capture instead
+    uint64_t capturers = ATTACK_TABLES.pawn[!isWhite][target] & position.getPieceBitboard(PAWN, isWhite);
+    for (; capturers; capturers = clearLsb(capturers)) {
+        int from = ctz(capturers);
+        uint64_t occupied = (position.getOccupied() ^ (1ULL << from) ^ capturedBB) | (1ULL << target);
+
+        if (!(position.attackersTo(king, occupied) & enemy & ~capturedBB)) {
+            *moves++ = Move(from, target, EN_PASSANT);
+        }
+    }
+}
+
+static void addCastling(const Position& position, int king, Move*& moves) {
+    bool isWhite = position.isWhiteToMove();
+    uint8_t rights = position.getCastlingRights() & (isWhite ? WHITE_KINGSIDE | WHITE_QUEENSIDE
+                                                              : BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    if (!rights || king != (isWhite ? 60 : 4)) return;
+
+    uint64_t occupied = position.getOccupied();
+    auto attacked = [&](int square) { return position.isSquareAttacked(square, !isWhite); };
+
+    // The rights are only cleared by moves, so check the rook is really home for hand-built positions
+    bool kingside = rights & (WHITE_KINGSIDE | BLACK_KINGSIDE);
+    if (kingside && position.getPieceTypeAt(king + 3) == ROOK && position.isWhiteAt(king + 3) == isWhite &&
+        !(occupied & ATTACK_TABLES.between[king][king + 3]) && !attacked(king + 1) && !attacked(king + 2)) {
+        *moves++ = Move(king, king + 2, CASTLING);
+    }
+
+    bool queenside = rights & (WHITE_QUEENSIDE | BLACK_QUEENSIDE);
+    if (queenside && position.getPieceTypeAt(king - 4) == ROOK && position.isWhiteAt(king - 4) == isWhite &&
+        !(occupied & ATTACK_TABLES.between[king][king - 4]) && !attacked(king - 1) && !attacked(king - 2)) {
+        *moves++ = Move(king, king - 2, CASTLING);
+    }
+}
+
+// Pushes and captures of a set of pawns that share the same allowed target squares
+template <GenType Type>
+static void addPawnSetMoves(uint64_t pawns, bool isWhite, uint64_t enemy, uint64_t empty, uint64_t allowed,
+                            Move*& moves) {
+    int forward = isWhite ? 8 : -8;
+
+    // Promotions count as captures, double pushes never promote
+    if (Type == QUIETS) allowed &= ~PROMOTION_RANKS;
+
+    uint64_t pushes = pawnSinglePushes(pawns, isWhite, empty);
+    if (Type == CAPTURES) pushes &= PROMOTION_RANKS;
+    addPawnMoves(pushes & allowed, forward, moves);
+    if (Type != CAPTURES) addPawnMoves(pawnDoublePushes(pawns, isWhite, empty) & allowed, 2 * forward, moves);
+
+    if (Type != QUIETS) {
+        addPawnMoves(pawnAttacksWest(pawns, isWhite) & enemy & allowed, isWhite ? 9 : -7, moves);
+        addPawnMoves(pawnAttacksEast(pawns, isWhite) & enemy & allowed, isWhite ? 7 : -9, moves);
+    }
+}
+
+template <GenType Type>
+Move* generateMoves(const Position& position, const CheckInfo& info, Move* moves) {
+    bool isWhite = position.isWhiteToMove();
+    uint64_t own = position.getColorBitboard(isWhite);
+    uint64_t enemy = position.getColorBitboard(!isWhite);
+    uint64_t occupied = own | enemy;
+    uint64_t empty = ~occupied;
+
+    uint64_t pieceMask = Type == CAPTURES ? enemy : Type == QUIETS ? empty : ~own;
+
+    // Double check, only the king can move
+    if (clearLsb(info.checkers)) {
+        addMoves(info.king, kingTargets(position, info, pieceMask), moves);
+        return moves;
+    }
+
+    uint64_t targetMask = pieceMask & info.checkMask;
+    auto pinLine = [&](int from) { return (info.pinned >> from) & 1 ? ATTACK_TABLES.line[info.king][from] : ~0ULL; };
+
+    // Unpinned pawns all at once, the few pinned ones each with their own line
+    uint64_t pawns = position.getPieceBitboard(PAWN, isWhite);
+    addPawnSetMoves<Type>(pawns & ~info.pinned, isWhite, enemy, empty, info.checkMask, moves);
+    for (uint64_t pinnedPawns = pawns & info.pinned; pinnedPawns; pinnedPawns = clearLsb(pinnedPawns)) {
+        int from = ctz(pinnedPawns);
+        addPawnSetMoves<Type>(1ULL << from, isWhite, enemy, empty, info.checkMask & pinLine(from), moves);
+    }
+
+    // a pinned knight can never stay on the pin line
+    for (uint64_t knights = position.getPieceBitboard(KNIGHT, isWhite) & ~info.pinned; knights;
+         knights = clearLsb(knights)) {
+        int from = ctz(knights);
+        addMoves(from, ATTACK_TABLES.knight[from] & targetMask, moves);
+    }
+
+    // Queens are generated as a bishop and a rook, each lookup shared with the matching piece type
+    uint64_t queens = position.getPieceBitboard(QUEEN, isWhite);
+    for (uint64_t bishops = position.getPieceBitboard(BISHOP, isWhite) | queens; bishops;
+         bishops = clearLsb(bishops)) {
+        int from = ctz(bishops);
+        addMoves(from, bishopMoves(from, occupied) & targetMask & pinLine(from), moves);
+    }
+
+    for (uint64_t rooks = position.getPieceBitboard(ROOK, isWhite) | queens; rooks; rooks = clearLsb(rooks)) {
+        int from = ctz(rooks);
+        addMoves(from, rookMoves(from, occupied) & targetMask & pinLine(from), moves);
+    }
+
+    addMoves(info.king, kingTargets(position, info, pieceMask), moves);
+    if (Type != QUIETS) addEnPassant(position, info.king, moves);
+    if (Type != CAPTURES && !info.checkers) addCastling(position, info.king, moves);
+    return moves;
+}
+
+template Move* generateMoves<CAPTURES>(const Position&, const CheckInfo&, Move*);
+template Move* generateMoves<QUIETS>(const Position&, const CheckInfo&, Move*);
+template Move* generateMoves<ALL>(const Position&, const CheckInfo&, Move*);
+
+Move* generateLegalMoves(const Position& position, Move* moves) {
+    return generateMoves<ALL>(position, CheckInfo(position), moves);
+}
+
+bool isLegalMove(const Position& position, const CheckInfo& info, Move move) {
+    int from = move.from();
+    int to = move.to();
+    uint64_t own = position.getColorBitboard(position.isWhiteToMove());
+    if (from == to || !((own >> from) & 1)) return false;
+
+    // Rare enough to generate them and compare
+    if (move.flag() == CASTLING || move.flag() == EN_PASSANT) {
+        Move special[2];
+        Move* end = special;
+        if (move.flag() == EN_PASSANT) {
+            addEnPassant(position, info.king, end);
+        } else if (!info.checkers) {
+            addCastling(position, info.king, end);
+        }
+
+        for (Move* candidate = special; candidate != end; ++candidate) {
+            if (*candidate == move) return true;
+        }
+        return false;
+    }
+
+    PieceType piece = position.getPieceTypeAt(from);
+    bool promotes = piece == PAWN && ((1ULL << to) & PROMOTION_RANKS);
+    if (promotes != (move.flag() == PROMOTION)) return false;
+
+    if (piece == KING) return (kingTargets(position, info, ~0ULL) >> to) & 1;
+    if (clearLsb(info.checkers)) return false;
+    return (pieceTargets(position, info, from, piece, own, position.getOccupied()) >> to) & 1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "Move.h"
+#include "Position.h"
+
+// No legal position has more moves than this
+constexpr int MAX_MOVES = 256;
+
+// Checks and pins for the side to move, computed once per node and shared by every generation stage
+struct CheckInfo {
+    explicit CheckInfo(const Position& position);
+
+    int king;
+    uint64_t checkers;
+    // squares a non-king move must land on, all of them unless in check
+    uint64_t checkMask;
+    uint64_t pinned;
+};
+
+enum GenType { CAPTURES, QUIETS, ALL };
+
+// Legal moves of one kind, written from the buffer start, returns the end. Promotions count as captures.
+template <GenType Type>
+Move* generateMoves(const Position& position, const CheckInfo& info, Move* moves);
+
+// Writes every legal move for the side to move from the buffer start, returns the end
+Move* generateLegalMoves(const Position& position, Move* moves);
+
+// Whether a move from elsewhere, a hash or killer move, is legal in this position
+bool isLegalMove(const Position& position, const CheckInfo& info, Move move);
+
+// Fixed capacity and uninitialized storage, lives in the caller's stack frame so the search never allocates
+class MoveList {
+public:
+    MoveList() = default;
+    explicit MoveList(const Position& position)
+        : count(static_cast<int>(generateLegalMoves(position, moves) - moves)) {}
+
+    void push_back(Move move) {
+        assert(count < MAX_MOVES && "move list overflow");
+        moves[count++] = move;
+    }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    Move operator[](int index) const { return moves[index]; }
+
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+
+private:
+    Move moves[MAX_MOVES];
+    int count = 0;
+};
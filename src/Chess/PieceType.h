@@ -1,6 +1,8 @@
 #pragma once
 
-enum PieceType { EMPTY = -1, PAWN = 0, ROOK = 1, KNIGHT = 2, BISHOP = 3, QUEEN = 4, KING = 5 };
+#include <cstdint>
+
+enum PieceType : int8_t { EMPTY = -1, PAWN = 0, ROOK = 1, KNIGHT = 2, BISHOP = 3, QUEEN = 4, KING = 5 };
 
 constexpr char EMPTY_SYMBOL = ' ';
 constexpr char PAWN_SYMBOL = 'P';
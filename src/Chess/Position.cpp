@@ -0,0 +1,725 @@
+#include "Position.h"
+
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "../AI/PieceSqTable.h"
+#include "./AttackTables.h"
+#include "./MoveGen.h"
+#include "./Zobrist.h"
+/*
+ * Bitboard usage:
+ *  - index = x + y * 8   get the index
+ *  - x = idx & 7         get the x (file)
+ *  - y = idx >> 3        get the y (rank)
+ *  - 1ULL << index       sets a bit at the square index
+ *  - (board & mask)      checks if a square is occupied
+ *  - board |= mask       adds a piece
+ *  - board &= ~mask      removes a piece
+ *
+ * Bit shifts are used to generate moves.
+ *
+ *  - North:              >> 8
+ *  - South:              << 8
+ *  - East:               << 1
+ *  - West:               >> 1
+ */
+
+// Rights that survive a move from or to each square, the king and rook home squares clear theirs
+constexpr std::array<uint8_t, 64> genCastlingKeep() {
+    std::array<uint8_t, 64> keep{};
+    for (auto& rights : keep) rights = ALL_CASTLING;
+
+    keep[0] = ALL_CASTLING & ~BLACK_QUEENSIDE;
+    keep[4] = ALL_CASTLING & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    keep[7] = ALL_CASTLING & ~BLACK_KINGSIDE;
+    keep[56] = ALL_CASTLING & ~WHITE_QUEENSIDE;
+    keep[60] = ALL_CASTLING & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+    keep[63] = ALL_CASTLING & ~WHITE_KINGSIDE;
+    return keep;
+}
+
+constexpr std::array<uint8_t, 64> CASTLING_KEEP = genCastlingKeep();
+
+// The rook jumps over the king, from the corner next to the king's target square
+inline void castlingRookSquares(int kingFrom, int kingTo, int& rookFrom, int& rookTo) {
+    bool kingside = kingTo > kingFrom;
+    rookFrom = kingside ? kingTo + 1 : kingTo - 2;
+    rookTo = kingside ? kingTo - 1 : kingTo + 1;
+}
+
+#if defined(ATTACK_MAPS)
+// Bit-sliced add and subtract, a ripple carry over the slices for all 64 squares at once
+static void addAttackCounts(uint64_t (&counts)[ATTACK_COUNT_BITS], uint64_t attacks) {
+    for (int i = 0; i < ATTACK_COUNT_BITS && attacks; ++i) {
+        uint64_t carry = counts[i] & attacks;
+        counts[i] ^= attacks;
+        attacks = carry;
+    }
+}
+
+static void subtractAttackCounts(uint64_t (&counts)[ATTACK_COUNT_BITS], uint64_t attacks) {
+    for (int i = 0; i < ATTACK_COUNT_BITS && attacks; ++i) {
+        uint64_t borrow = ~counts[i] & attacks;
+        counts[i] ^= attacks;
+        attacks = borrow;
+    }
+}
+#endif
+
+void Position::clear() {
+    for (auto& bitboard : pieces) bitboard = 0;
+    colors[0] = 0;
+    colors[1] = 0;
+    for (auto& square : squares) square = EMPTY;
+    hash = 0;
+    eval = 0;
+    whiteToMove = true;
+    castlingRights = NO_CASTLING;
+    enPassantSquare = NO_SQUARE;
+    lastMove = Move::none();
+#if defined(ATTACK_MAPS)
+    for (auto& side : attackCounts) {
+        for (auto& slice : side) slice = 0;
+    }
+    attackState = ATTACKS_CURRENT;
+    lastCaptured = EMPTY;
+#endif
+}
+
+static PieceType symbolToPieceType(char symbol) {
+    switch (toupper(symbol)) {
+        case PAWN_SYMBOL:
+            return PAWN;
+        case ROOK_SYMBOL:
+            return ROOK;
+        case KNIGHT_SYMBOL:
+            return KNIGHT;
+        case BISHOP_SYMBOL:
+            return BISHOP;
+        case QUEEN_SYMBOL:
+            return QUEEN;
+        case KING_SYMBOL:
+            return KING;
+        default:
+            return EMPTY;
+    }
+}
+
+bool Position::setFromFen(const std::string& fen) {
+    std::istringstream fields(fen);
+    std::string placement, side, castling, enPassant;
+    if (!(fields >> placement >> side >> castling >> enPassant)) return false;
+
+    clear();
+
+    // Ranks run from 8 to 1, which is index order with a8 = 0
+    int square = 0;
+    for (char c : placement) {
+        if (c == '/') continue;
+
+        if (c >= '1' && c <= '8') {
+            square += c - '0';
+        } else {
+            PieceType pieceType = symbolToPieceType(c);
+            if (pieceType == EMPTY || square >= 64) return false;
+            setPiece(square++, pieceType, isupper(c));
+        }
+    }
+    if (square != 64) return false;
+    if (popcount(pieces[KING] & colors[true]) != 1 || popcount(pieces[KING] & colors[false]) != 1) return false;
+
+    if (side != "w" && side != "b") return false;
+    setWhiteToMove(side == "w");
+
+    uint8_t rights = NO_CASTLING;
+    for (char c : castling) {
+        switch (c) {
+            case 'K':
+                rights |= WHITE_KINGSIDE;
+                break;
+            case 'Q':
+                rights |= WHITE_QUEENSIDE;
+                break;
+            case 'k':
+                rights |= BLACK_KINGSIDE;
+                break;
+            case 'q':
+                rights |= BLACK_QUEENSIDE;
+                break;
+            case '-':
+                break;
+            default:
+                return false;
+        }
+    }
+    setCastlingRights(rights);
+
+    if (enPassant != "-") {
+        if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+            (enPassant[1] != '3' && enPassant[1] != '6')) {
+            return false;
+        }
+
+        // Same rule as makeMove, only recorded when a pawn can actually take
+        int target = (enPassant[0] - 'a') + ('8' - enPassant[1]) * 8;
+        if (ATTACK_TABLES.pawn[!whiteToMove][target] & pieces[PAWN] & colors[whiteToMove]) {
+            setEnPassantSquare(target);
+        }
+    }
+
+    assert(isConsistent() && "incremental state out of sync with bitboards");
+    return true;
+}
+
+std::string Position::toFen() const {
+    std::string fen;
+
+    for (int y = 0; y < 8; ++y) {
+        int emptyRun = 0;
+        for (int x = 0; x < 8; ++x) {
+            int square = x + y * 8;
+            if (squares[square] == EMPTY) {
+                emptyRun++;
+                continue;
+            }
+            if (emptyRun) fen += static_cast<char>('0' + emptyRun);
+            emptyRun = 0;
+
+            char symbol = pieceTypeToSymbol(squares[square]);
+            fen += isWhiteAt(square) ? symbol : static_cast<char>(tolower(symbol));
+        }
+        if (emptyRun) fen += static_cast<char>('0' + emptyRun);
+        if (y < 7) fen += '/';
+    }
+
+    fen += whiteToMove ? " w " : " b ";
+
+    if (castlingRights == NO_CASTLING) fen += '-';
+    if (castlingRights & WHITE_KINGSIDE) fen += 'K';
+    if (castlingRights & WHITE_QUEENSIDE) fen += 'Q';
+    if (castlingRights & BLACK_KINGSIDE) fen += 'k';
+    if (castlingRights & BLACK_QUEENSIDE) fen += 'q';
+
+    if (enPassantSquare == NO_SQUARE) {
+        fen += " -";
+    } else {
+        fen += ' ';
+        fen += static_cast<char>('a' + (enPassantSquare & 7));
+        fen += static_cast<char>('8' - (enPassantSquare >> 3));
+    }
+
+    return fen + " 0 1";
+}
+
+void Position::setWhiteToMove(bool isWhite) {
+    if (whiteToMove != isWhite) {
+        hash ^= ZOBRIST_KEYS.sideToMove;
+        whiteToMove = isWhite;
+    }
+}
+
+void Position::setCastlingRights(uint8_t rights) {
+    hash ^= ZOBRIST_KEYS.castling[castlingRights] ^ ZOBRIST_KEYS.castling[rights];
+    castlingRights = rights;
+}
+
+void Position::setEnPassantSquare(int square) {
+    if (enPassantSquare != NO_SQUARE) hash ^= ZOBRIST_KEYS.enPassant[enPassantSquare & 7];
+    if (square != NO_SQUARE) hash ^= ZOBRIST_KEYS.enPassant[square & 7];
+    enPassantSquare = static_cast<int8_t>(square);
+}
+
+void Position::placePiece(int square, PieceType pieceType, bool isWhite) {
+    uint64_t piece = 1ULL << square;
+    colors[isWhite] |= piece;
+    pieces[pieceType] |= piece;
+    squares[square] = pieceType;
+}
+
+void Position::liftPiece(int square) {
+    uint64_t piece = 1ULL << square;
+    colors[0] &= ~piece;
+    colors[1] &= ~piece;
+    pieces[squares[square]] &= ~piece;
+    squares[square] = EMPTY;
+}
+
+void Position::setPiece(int square, PieceType pieceType, bool isWhite) {
+    removePiece(square);
+    placePiece(square, pieceType, isWhite);
+    hash ^= zobristKey(pieceType, isWhite, square);
+    eval += pieceSquareValue(pieceType, isWhite, square);
+#if defined(ATTACK_MAPS)
+    attackState = ATTACKS_STALE;
+#endif
+}
+
+void Position::removePiece(int square) {
+    PieceType pieceType = squares[square];
+    if (pieceType == EMPTY) return;
+
+    bool isWhite = isWhiteAt(square);
+    hash ^= zobristKey(pieceType, isWhite, square);
+    eval -= pieceSquareValue(pieceType, isWhite, square);
+    liftPiece(square);
+#if defined(ATTACK_MAPS)
+    attackState = ATTACKS_STALE;
+#endif
+}
+
+#if defined(ATTACK_MAPS)
+void Position::updateAttacks() const {
+    if (attackState == ATTACKS_ONE_MOVE_BEHIND) {
+        applyLastMoveToAttacks(attackCounts);
+    } else {
+        computeAttacks(attackCounts);
+    }
+    attackState = ATTACKS_CURRENT;
+}
+
+// Takes the parent's counts to this position's, the pieces on the board are this position's
+void Position::applyLastMoveToAttacks(uint64_t (&counts)[2][ATTACK_COUNT_BITS]) const {
+    int from = lastMove.from();
+    int to = lastMove.to();
+    bool mover = !whiteToMove;
+    uint64_t occupied = getOccupied();
+
+    // Pieces on the touched squares changed, the changed squares also emptied or filled
+    uint64_t touched = (1ULL << from) | (1ULL << to);
+    uint64_t changed = lastCaptured == EMPTY ? touched : 1ULL << from;
+    int capturedSquare = NO_SQUARE;
+    int rookFrom = NO_SQUARE;
+    int rookTo = NO_SQUARE;
+
+    if (lastMove.flag() == EN_PASSANT) {
+        capturedSquare = mover ? to + 8 : to - 8;
+        touched |= 1ULL << capturedSquare;
+        changed |= 1ULL << capturedSquare;
+    } else if (lastMove.flag() == CASTLING) {
+        castlingRookSquares(from, to, rookFrom, rookTo);
+        touched |= (1ULL << rookFrom) | (1ULL << rookTo);
+        changed |= (1ULL << rookFrom) | (1ULL << rookTo);
+    }
+    uint64_t before = occupied ^ changed;
+
+    // The pieces that stood on the touched squares, and the ones standing there now
+    uint64_t(&moverCounts)[ATTACK_COUNT_BITS] = counts[mover];
+    uint64_t(&enemyCounts)[ATTACK_COUNT_BITS] = counts[!mover];
+    PieceType moved = lastMove.flag() == PROMOTION ? PAWN : squares[to];
+
+    subtractAttackCounts(moverCounts, pieceAttacks(moved, mover, from, before));
+    addAttackCounts(moverCounts, pieceAttacks(squares[to], mover, to, occupied));
+    if (lastCaptured != EMPTY) subtractAttackCounts(enemyCounts, pieceAttacks(lastCaptured, !mover, to, before));
+    if (capturedSquare != NO_SQUARE) subtractAttackCounts(enemyCounts, ATTACK_TABLES.pawn[!mover][capturedSquare]);
+    if (rookFrom != NO_SQUARE) {
+        subtractAttackCounts(moverCounts, rookMoves(rookFrom, before));
+        addAttackCounts(moverCounts, rookMoves(rookTo, occupied));
+    }
+
+    // A slider's ray can only change past a square that emptied or filled, and the nearest such square on the
+    // ray is attacked both before and after, so searching from the changed squares finds every one
+    uint64_t rookLike = pieces[ROOK] | pieces[QUEEN];
+    uint64_t bishopLike = pieces[BISHOP] | pieces[QUEEN];
+    uint64_t sliders = 0;
+    for (uint64_t set = changed; set; set = clearLsb(set)) {
+        int square = ctz(set);
+        sliders |= (rookMoves(square, occupied) & rookLike) | (bishopMoves(square, occupied) & bishopLike);
+    }
+
+    for (sliders &= ~touched; sliders; sliders = clearLsb(sliders)) {
+        int square = ctz(sliders);
+        bool isWhite = isWhiteAt(square);
+        uint64_t old = pieceAttacks(squares[square], isWhite, square, before);
+        uint64_t now = pieceAttacks(squares[square], isWhite, square, occupied);
+        subtractAttackCounts(counts[isWhite], old & ~now);
+        addAttackCounts(counts[isWhite], now & ~old);
+    }
+}
+
+void Position::computeAttacks(uint64_t (&counts)[2][ATTACK_COUNT_BITS]) const {
+    uint64_t occupied = getOccupied();
+    for (bool isWhite : {false, true}) {
+        for (auto& slice : counts[isWhite]) slice = 0;
+        for (uint64_t set = colors[isWhite]; set; set = clearLsb(set)) {
+            int square = ctz(set);
+            addAttackCounts(counts[isWhite], pieceAttacks(squares[square], isWhite, square, occupied));
+        }
+    }
+}
+
+int Position::getAttackerCount(int square, bool byWhite) const {
+    if (attackState != ATTACKS_CURRENT) updateAttacks();
+
+    int count = 0;
+    for (int i = 0; i < ATTACK_COUNT_BITS; ++i) {
+        count |= static_cast<int>((attackCounts[byWhite][i] >> square) & 1) << i;
+    }
+    return count;
+}
+#else
+uint64_t Position::getAttackedSquares(bool byWhite) const {
+    uint64_t occupied = getOccupied();
+    uint64_t attacked = 0;
+    for (uint64_t set = colors[byWhite]; set; set = clearLsb(set)) {
+        int square = ctz(set);
+        attacked |= pieceAttacks(squares[square], byWhite, square, occupied);
+    }
+    return attacked;
+}
+
+int Position::getAttackerCount(int square, bool byWhite) const {
+    return popcount(attackersTo(square, getOccupied()) & colors[byWhite]);
+}
+#endif
+
+bool Position::movePiece(Move move) {
+    PieceType promotion = move.flag() == PROMOTION ? move.promotion() : QUEEN;
+
+    for (Move legal : MoveList(*this)) {
+        if (legal.from() != move.from() || legal.to() != move.to()) continue;
+        if (legal.flag() == PROMOTION && legal.promotion() != promotion) continue;
+
+        UndoState undo;
+        makeMove(legal, undo);
+        return true;
+    }
+    return false;
+}
+
+void Position::makeMove(Move move, UndoState& undo) {
+    int from = move.from();
+    int to = move.to();
+    uint64_t toBB = 1ULL << to;
+    uint64_t fromTo = (1ULL << from) | toBB;
+
+    PieceType piece = squares[from];
+    PieceType captured = squares[to];
+    bool isWhite = whiteToMove;
+
+#if defined(ATTACK_MAPS)
+    // the counts are only worth saving while they match the pieces
+    if (attackState == ATTACKS_CURRENT) std::memcpy(undo.attackCounts, attackCounts, sizeof(attackCounts));
+    undo.attackState = attackState;
+    undo.lastCaptured = lastCaptured;
+#endif
+    undo.lastMove = lastMove;
+    undo.move = move;
+    undo.hash = hash;
+    undo.eval = eval;
+    undo.captured = captured;
+    undo.castlingRights = castlingRights;
+    undo.enPassantSquare = enPassantSquare;
+
+    if (enPassantSquare != NO_SQUARE) {
+        hash ^= ZOBRIST_KEYS.enPassant[enPassantSquare & 7];
+        enPassantSquare = NO_SQUARE;
+    }
+
+    if (captured != EMPTY) {
+        colors[!isWhite] ^= toBB;
+        pieces[captured] ^= toBB;
+        hash ^= zobristKey(captured, !isWhite, to);
+        eval -= pieceSquareValue(captured, !isWhite, to);
+    }
+
+    colors[isWhite] ^= fromTo;
+    pieces[piece] ^= fromTo;
+    squares[to] = piece;
+    squares[from] = EMPTY;
+
+    hash ^= zobristKey(piece, isWhite, from) ^ zobristKey(piece, isWhite, to);
+    eval += pieceSquareValue(piece, isWhite, to) - pieceSquareValue(piece, isWhite, from);
+
+    switch (move.flag()) {
+        case PROMOTION: {
+            PieceType promoted = move.promotion();
+            pieces[PAWN] ^= toBB;
+            pieces[promoted] ^= toBB;
+            squares[to] = promoted;
+            hash ^= zobristKey(PAWN, isWhite, to) ^ zobristKey(promoted, isWhite, to);
+            eval += pieceSquareValue(promoted, isWhite, to) - pieceSquareValue(PAWN, isWhite, to);
+            break;
+        }
+
+        case EN_PASSANT: {
+            // the captured pawn sits behind the target square
+            int capturedSquare = isWhite ? to + 8 : to - 8;
+            uint64_t capturedBB = 1ULL << capturedSquare;
+            colors[!isWhite] ^= capturedBB;
+            pieces[PAWN] ^= capturedBB;
+            squares[capturedSquare] = EMPTY;
+            hash ^= zobristKey(PAWN, !isWhite, capturedSquare);
+            eval -= pieceSquareValue(PAWN, !isWhite, capturedSquare);
+            break;
+        }
+
+        case CASTLING: {
+            int rookFrom, rookTo;
+            castlingRookSquares(from, to, rookFrom, rookTo);
+            uint64_t rookFromTo = (1ULL << rookFrom) | (1ULL << rookTo);
+            colors[isWhite] ^= rookFromTo;
+            pieces[ROOK] ^= rookFromTo;
+            squares[rookTo] = ROOK;
+            squares[rookFrom] = EMPTY;
+            hash ^= zobristKey(ROOK, isWhite, rookFrom) ^ zobristKey(ROOK, isWhite, rookTo);
+            eval += pieceSquareValue(ROOK, isWhite, rookTo) - pieceSquareValue(ROOK, isWhite, rookFrom);
+            break;
+        }
+
+        default:
+            // a double push only sets the square when an enemy pawn can take it, keeping the hash canonical
+            if (piece == PAWN && (to - from == 16 || from - to == 16)) {
+                int square = (from + to) / 2;
+                if (ATTACK_TABLES.pawn[isWhite][square] & pieces[PAWN] & colors[!isWhite]) {
+                    enPassantSquare = static_cast<int8_t>(square);
+                    hash ^= ZOBRIST_KEYS.enPassant[square & 7];
+                }
+            }
+            break;
+    }
+
+    uint8_t rights = castlingRights & CASTLING_KEEP[from] & CASTLING_KEEP[to];
+    hash ^= ZOBRIST_KEYS.castling[castlingRights] ^ ZOBRIST_KEYS.castling[rights] ^ ZOBRIST_KEYS.sideToMove;
+    castlingRights = rights;
+    whiteToMove = !isWhite;
+
+#if defined(ATTACK_MAPS)
+    attackState = attackState == ATTACKS_CURRENT ? ATTACKS_ONE_MOVE_BEHIND : ATTACKS_STALE;
+    lastCaptured = captured;
+#endif
+    lastMove = move;
+
+    assert(isConsistent() && "incremental state out of sync with bitboards");
+}
+
+void Position::makeNullMove(UndoState& undo) {
+#if defined(ATTACK_MAPS)
+    if (attackState != ATTACKS_CURRENT) updateAttacks();
+    undo.lastCaptured = lastCaptured;
+    lastCaptured = EMPTY;
+#endif
+
+    undo.lastMove = lastMove;
+    undo.move = Move::none();
+    undo.hash = hash;
+    undo.enPassantSquare = enPassantSquare;
+
+    if (enPassantSquare != NO_SQUARE) {
+        hash ^= ZOBRIST_KEYS.enPassant[enPassantSquare & 7];
+        enPassantSquare = NO_SQUARE;
+    }
+    hash ^= ZOBRIST_KEYS.sideToMove;
+    whiteToMove = !whiteToMove;
+    lastMove = Move::none();
+}
+
+// Whatever state any counts are left in also holds for this position, it has the same pieces
+void Position::unmakeNullMove(const UndoState& undo) {
+#if defined(ATTACK_MAPS)
+    lastCaptured = undo.lastCaptured;
+#endif
+    lastMove = undo.lastMove;
+    hash = undo.hash;
+    enPassantSquare = undo.enPassantSquare;
+    whiteToMove = !whiteToMove;
+}
+
+void Position::unmakeMove(const UndoState& undo) {
+    Move move = undo.move;
+    int from = move.from();
+    int to = move.to();
+    uint64_t toBB = 1ULL << to;
+    uint64_t fromTo = (1ULL << from) | toBB;
+
+    bool isWhite = !whiteToMove;
+
+    if (move.flag() == PROMOTION) {
+        pieces[move.promotion()] ^= toBB;
+        pieces[PAWN] ^= toBB;
+        squares[to] = PAWN;
+    } else if (move.flag() == CASTLING) {
+        int rookFrom, rookTo;
+        castlingRookSquares(from, to, rookFrom, rookTo);
+        uint64_t rookFromTo = (1ULL << rookFrom) | (1ULL << rookTo);
+        colors[isWhite] ^= rookFromTo;
+        pieces[ROOK] ^= rookFromTo;
+        squares[rookFrom] = ROOK;
+        squares[rookTo] = EMPTY;
+    }
+
+    PieceType piece = squares[to];
+
+    colors[isWhite] ^= fromTo;
+    pieces[piece] ^= fromTo;
+    squares[from] = piece;
+    squares[to] = undo.captured;
+
+    if (undo.captured != EMPTY) {
+        colors[!isWhite] ^= toBB;
+        pieces[undo.captured] ^= toBB;
+    } else if (move.flag() == EN_PASSANT) {
+        int capturedSquare = isWhite ? to + 8 : to - 8;
+        uint64_t capturedBB = 1ULL << capturedSquare;
+        colors[!isWhite] ^= capturedBB;
+        pieces[PAWN] ^= capturedBB;
+        squares[capturedSquare] = PAWN;
+    }
+
+#if defined(ATTACK_MAPS)
+    // Counts one move behind never caught up with this move, so they are still the restored position's. Any
+    // others may have been rebuilt further down and only a saved copy brings them back.
+    if (attackState == ATTACKS_ONE_MOVE_BEHIND) {
+        attackState = ATTACKS_CURRENT;
+    } else if (attackState == ATTACKS_CURRENT && undo.attackState == ATTACKS_CURRENT) {
+        std::memcpy(attackCounts, undo.attackCounts, sizeof(attackCounts));
+    } else {
+        attackState = ATTACKS_STALE;
+    }
+    lastCaptured = undo.lastCaptured;
+#endif
+    lastMove = undo.lastMove;
+    hash = undo.hash;
+    eval = undo.eval;
+    castlingRights = undo.castlingRights;
+    enPassantSquare = undo.enPassantSquare;
+    whiteToMove = isWhite;
+
+    assert(isConsistent() && "incremental state out of sync with bitboards");
+}
+
+int Position::getKingSquare(bool isWhite) const {
+    uint64_t king = pieces[KING] & colors[isWhite];
+    assert(king && "position without a king");
+    return ctz(king);
+}
+
+uint64_t Position::attackersTo(int square, uint64_t occupied) const {
+    // a pawn attacks the square if a pawn of the other color on that square would attack it
+    return (ATTACK_TABLES.pawn[false][square] & pieces[PAWN] & colors[true]) |
+           (ATTACK_TABLES.pawn[true][square] & pieces[PAWN] & colors[false]) |
+           (ATTACK_TABLES.knight[square] & pieces[KNIGHT]) | (ATTACK_TABLES.king[square] & pieces[KING]) |
+           (rookMoves(square, occupied) & (pieces[ROOK] | pieces[QUEEN])) |
+           (bishopMoves(square, occupied) & (pieces[BISHOP] | pieces[QUEEN]));
+}
+
+// Cheapest tests first, the slider lookups only run when nothing else attacks
+bool Position::isSquareAttacked(int square, bool byWhite, uint64_t occupied) const {
+    uint64_t enemy = colors[byWhite];
+    if (ATTACK_TABLES.pawn[!byWhite][square] & pieces[PAWN] & enemy) return true;
+    if (ATTACK_TABLES.knight[square] & pieces[KNIGHT] & enemy) return true;
+    if (ATTACK_TABLES.king[square] & pieces[KING] & enemy) return true;
+
+    uint64_t bishopLike = (pieces[BISHOP] | pieces[QUEEN]) & enemy;
+    uint64_t rookLike = (pieces[ROOK] | pieces[QUEEN]) & enemy;
+    return (bishopLike && (bishopMoves(square, occupied) & bishopLike)) ||
+           (rookLike && (rookMoves(square, occupied) & rookLike));
+}
+
+uint64_t Position::getValidMoves(int square) const {
+    uint64_t targets = 0;
+    for (Move move : MoveList(*this)) {
+        if (move.from() == square) targets |= 1ULL << move.to();
+    }
+    return targets;
+}
+
+uint64_t Position::getPseudoLegalMoves(int from) const {
+    bool white = isWhiteAt(from);
+    uint64_t own = colors[white];
+    uint64_t occ = getOccupied();
+
+    switch (squares[from]) {
+        case KNIGHT:
+            return ATTACK_TABLES.knight[from] & ~own;
+
+        case KING:
+            return ATTACK_TABLES.king[from] & ~own;
+
+        case PAWN: {
+            uint64_t enemy = occ ^ own;
+            return pawnPushes(from, white, occ) | (ATTACK_TABLES.pawn[white][from] & enemy);
+        }
+
+        case ROOK:
+            return rookMoves(from, occ) & ~own;
+
+        case BISHOP:
+            return bishopMoves(from, occ) & ~own;
+
+        case QUEEN:
+            return (rookMoves(from, occ) | bishopMoves(from, occ)) & ~own;
+
+        default:
+            return 0;
+    }
+}
+
+bool Position::isConsistent() const {
+    if (colors[0] & colors[1]) return false;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t mask = 1ULL << sq;
+        bool occupied = getOccupied() & mask;
+
+        if (squares[sq] == EMPTY) {
+            if (occupied) return false;
+            for (int i = 0; i < 6; ++i) {
+                if (pieces[i] & mask) return false;
+            }
+        } else {
+            if (!occupied) return false;
+            for (int i = 0; i < 6; ++i) {
+                if (((pieces[i] & mask) != 0) != (i == squares[sq])) return false;
+            }
+        }
+    }
+    if (hash != computeHash() || eval != computeEval()) return false;
+
+#if defined(ATTACK_MAPS)
+    // Counts one move behind are caught up on a copy, so the incremental update is checked without the cached
+    // state moving on. Stale counts hold nothing to check.
+    if (attackState == ATTACKS_STALE) return true;
+
+    uint64_t cached[2][ATTACK_COUNT_BITS];
+    std::memcpy(cached, attackCounts, sizeof(cached));
+    if (attackState == ATTACKS_ONE_MOVE_BEHIND) applyLastMoveToAttacks(cached);
+
+    uint64_t counts[2][ATTACK_COUNT_BITS];
+    computeAttacks(counts);
+    return std::memcmp(counts, cached, sizeof(counts)) == 0;
+#else
+    return true;
+#endif
+}
+
+uint64_t Position::computeHash() const {
+    uint64_t h = whiteToMove ? 0 : ZOBRIST_KEYS.sideToMove;
+    h ^= ZOBRIST_KEYS.castling[castlingRights];
+    if (enPassantSquare != NO_SQUARE) h ^= ZOBRIST_KEYS.enPassant[enPassantSquare & 7];
+
+    for (int square = 0; square < 64; ++square) {
+        if (squares[square] != EMPTY) {
+            h ^= zobristKey(squares[square], isWhiteAt(square), square);
+        }
+    }
+
+    return h;
+}
+
+int32_t Position::computeEval() const {
+    int32_t e = 0;
+
+    for (int square = 0; square < 64; ++square) {
+        if (squares[square] != EMPTY) {
+            e += pieceSquareValue(squares[square], isWhiteAt(square), square);
+        }
+    }
+
+    return e;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "Move.h"
+#include "PieceType.h"
+
+#if defined(ATTACK_MAPS)
+// Enough bits per square for 16 attackers, a side never has more pieces
+constexpr int ATTACK_COUNT_BITS = 5;
+
+// How far the attack counts lag behind the pieces
+enum AttackState : uint8_t { ATTACKS_CURRENT, ATTACKS_ONE_MOVE_BEHIND, ATTACKS_STALE };
+#endif
+
+// What unmakeMove needs to restore a position without searching for it
+struct UndoState {
+#if defined(ATTACK_MAPS)
+    uint64_t attackCounts[2][ATTACK_COUNT_BITS];
+    AttackState attackState;
+    PieceType lastCaptured;
+#endif
+    Move lastMove;
+    uint64_t hash;
+    int32_t eval;
+    Move move;
+    PieceType captured;
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+};
+
+enum CastlingRights : uint8_t {
+    NO_CASTLING = 0,
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8,
+    ALL_CASTLING = 15
+};
+
+constexpr int NO_SQUARE = -1;
+
+/*
+ * The complete state of a game, as a flat trivially copyable value.
+ *
+ * Copying one is a plain memcpy, so the search can copy-make instead of
+ * undoing moves, and the UI can snapshot the game without a ChessBoard.
+ * Squares are indexed x + y * 8 (a8 = 0, h1 = 63), colors by isWhite.
+ *
+ * Built with ATTACK_MAPS, it also carries attacker counts per side, updated
+ * incrementally. They add 80 bytes to every copy and undo entry and cost the
+ * search more than they save, so by default attack queries are answered from
+ * the bitboards. With the maps, attack queries bring the lazy counts up to
+ * date, so threads should each work on their own copy.
+ */
+class Position {
+public:
+    void clear();
+
+    // Forsyth-Edwards Notation, the move counters are accepted but not kept
+    static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    bool setFromFen(const std::string& fen);
+    std::string toFen() const;
+
+    uint64_t getOccupied() const { return colors[0] | colors[1]; }
+    uint64_t getColorBitboard(bool isWhite) const { return colors[isWhite]; }
+    uint64_t getPieceBitboard(PieceType pieceType, bool isWhite) const { return pieces[pieceType] & colors[isWhite]; }
+    PieceType getPieceTypeAt(int square) const { return squares[square]; }
+    bool isWhiteAt(int square) const { return (colors[1] >> square) & 1; }
+
+    bool isWhiteToMove() const { return whiteToMove; }
+    void setWhiteToMove(bool isWhite);
+
+    // Castling rights only record that the king and rook have not moved, not that castling is legal now
+    uint8_t getCastlingRights() const { return castlingRights; }
+    void setCastlingRights(uint8_t rights);
+
+    // Square a pawn can capture onto en passant, only set when an enemy pawn can actually reach it
+    int getEnPassantSquare() const { return enPassantSquare; }
+    void setEnPassantSquare(int square);
+
+    // Zobrist hash of the pieces, side to move, castling rights and en passant file
+    uint64_t getHash() const { return hash; }
+
+    // Material plus piece-square score, white minus black
+    int getEval() const { return eval; }
+
+    // The move made to reach this position, Move::none() for a position that was set up
+    Move getLastMove() const { return lastMove; }
+
+    void setPiece(int square, PieceType pieceType, bool isWhite);
+    void removePiece(int square);
+
+    int getKingSquare(bool isWhite) const;
+
+    // Pieces of both colors attacking a square, given a custom occupancy for x-ray checks
+    uint64_t attackersTo(int square, uint64_t occupied) const;
+
+    // Squares attacked by one side and how many of its pieces attack each
+#if defined(ATTACK_MAPS)
+    uint64_t getAttackedSquares(bool byWhite) const {
+        if (attackState != ATTACKS_CURRENT) updateAttacks();
+        const uint64_t* counts = attackCounts[byWhite];
+        return counts[0] | counts[1] | counts[2] | counts[3] | counts[4];
+    }
+    bool isSquareAttacked(int square, bool byWhite) const { return (getAttackedSquares(byWhite) >> square) & 1; }
+#else
+    uint64_t getAttackedSquares(bool byWhite) const;
+    bool isSquareAttacked(int square, bool byWhite) const { return isSquareAttacked(square, byWhite, getOccupied()); }
+#endif
+    int getAttackerCount(int square, bool byWhite) const;
+
+    bool isSquareAttacked(int square, bool byWhite, uint64_t occupied) const;
+    bool isInCheck() const { return isSquareAttacked(getKingSquare(whiteToMove), !whiteToMove); }
+
+    // Targets ignoring checks, pins and special moves, kept as the movegen benchmark baseline
+    uint64_t getPseudoLegalMoves(int square) const;
+
+    // Legal targets of the piece on a square, empty unless it belongs to the side to move
+    uint64_t getValidMoves(int square) const;
+
+    // Validated move for the UI and the AI, only from, to and the promotion piece (queen unless
+    // flagged otherwise) need to be set, castling and en passant flags come from the matching legal move
+    bool movePiece(Move move);
+
+    // Search fast path, the move must come from generateLegalMoves
+    void makeMove(Move move, UndoState& undo);
+    void unmakeMove(const UndoState& undo);
+
+    // Passes the turn for null-move pruning, never while in check. The pieces stay put, so any attack counts are
+    // brought up to date once and shared with the position after the pass.
+    void makeNullMove(UndoState& undo);
+    void unmakeNullMove(const UndoState& undo);
+
+    // debug check that the mailbox, hash, eval and any attack counts match the bitboards, leaves the counts as they are
+    bool isConsistent() const;
+
+private:
+    uint64_t pieces[6];
+    uint64_t colors[2];
+    uint64_t hash;
+    int32_t eval;
+
+    // mailbox, piece type per square index kept in sync with the bitboards
+    PieceType squares[64];
+
+    bool whiteToMove;
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+    Move lastMove;
+
+#if defined(ATTACK_MAPS)
+    // Bit-sliced attacker counts per side, slice i holds bit i of every square's count. makeMove only records
+    // the move, the first query applies it to the parent's counts, so leaf moves never pay for an update.
+    mutable AttackState attackState;
+    PieceType lastCaptured;
+    mutable uint64_t attackCounts[2][ATTACK_COUNT_BITS];
+#endif
+
+    // Bitboard and mailbox updates only, for callers that restore hash and eval themselves
+    void placePiece(int square, PieceType pieceType, bool isWhite);
+    void liftPiece(int square);
+
+#if defined(ATTACK_MAPS)
+    void updateAttacks() const;
+    void applyLastMoveToAttacks(uint64_t (&counts)[2][ATTACK_COUNT_BITS]) const;
+    void computeAttacks(uint64_t (&counts)[2][ATTACK_COUNT_BITS]) const;
+#endif
+
+    uint64_t computeHash() const;
+    int32_t computeEval() const;
+};
+
+static_assert(std::is_trivially_copyable_v<Position>, "Position must stay memcpy-able");
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+struct ZobristKeys {
+    // [piece + 6 * isBlack][square]
+    std::array<std::array<uint64_t, 64>, 12> pieces;
+    uint64_t sideToMove;
+    // indexed by the castling rights bit set and the en passant file
+    std::array<uint64_t, 16> castling;
+    std::array<uint64_t, 8> enPassant;
+};
+
+// splitmix64, a fixed seed keeps hashes reproducible between runs
+constexpr uint64_t nextZobristKey(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys genZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 123456;
+
+    for (auto& piece : keys.pieces) {
+        for (auto& key : piece) {
+            key = nextZobristKey(state);
+        }
+    }
+    keys.sideToMove = nextZobristKey(state);
+
+    // no rights hashes to 0 so an empty board still hashes to 0
+    for (int rights = 1; rights < 16; ++rights) {
+        keys.castling[rights] = nextZobristKey(state);
+    }
+    for (auto& key : keys.enPassant) {
+        key = nextZobristKey(state);
+    }
+
+    return keys;
+}
+
+inline constexpr ZobristKeys ZOBRIST_KEYS = genZobristKeys();
+
+constexpr uint64_t zobristKey(int pieceType, bool isWhite, int square) {
+    return ZOBRIST_KEYS.pieces[isWhite ? pieceType : pieceType + 6][square];
+}
@@ -36,6 +36,26 @@ void Config::loadConfigFile() {
                     difficulty = std::stoi(value);
                 } else if (key == "time_limit") {
                     timeLimit = std::stoi(value);
+                } else if (key == "hash_size") {
+                    hashSize = std::stoi(value);
+                } else if (key == "threads") {
+                    threads = std::stoi(value);
+                } else if (key == "search_mode") {
+                    searchMode = value;
+                } else if (key == "null_move") {
+                    nullMove = value == "true";
+                } else if (key == "late_move_reductions") {
+                    lateMoveReductions = value == "true";
+                } else if (key == "futility_pruning") {
+                    futilityPruning = value == "true";
+                } else if (key == "reverse_futility") {
+                    reverseFutility = value == "true";
+                } else if (key == "ponder") {
+                    ponder = value == "true";
+                } else if (key == "book") {
+                    book = value;
+                } else if (key == "tablebase_dir") {
+                    tablebaseDir = value;
                 }
             }
         }
@@ -14,6 +14,16 @@ public:
     bool useGui = false;
     int difficulty = 1;
     int timeLimit = 1000;
+    int hashSize = 16;
+    int threads = 0;
+    std::string searchMode = "lazy_smp";
+    bool nullMove = true;
+    bool lateMoveReductions = true;
+    bool futilityPruning = true;
+    bool reverseFutility = true;
+    bool ponder = true;
+    std::string book;
+    std::string tablebaseDir;
 
     Config(const Config &) = delete;
     Config &operator=(const Config &) = delete;
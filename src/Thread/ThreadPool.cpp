@@ -3,7 +3,7 @@
 #include <stdexcept>
 #include <thread>
 
-ThreadPool::ThreadPool() {
+ThreadPool::ThreadPool(unsigned int nThreads) : nThreads(nThreads) {
     for (size_t i = 0; i < nThreads; i++) {
         workers.emplace_back(&ThreadPool::workerLoop, this);
     }
@@ -9,14 +9,14 @@
 
 class ThreadPool {
 public:
-    ThreadPool();
+    explicit ThreadPool(unsigned int nThreads = std::thread::hardware_concurrency());
     ~ThreadPool();
     void submit(std::function<void()> task);
     void join();
 
 private:
     std::atomic<size_t> activeTasks{0};
-    unsigned int nThreads = std::thread::hardware_concurrency();
+    unsigned int nThreads;
     std::vector<std::thread> workers;
     std::queue<std::function<void()>> tasks;
     std::mutex queueMutex;
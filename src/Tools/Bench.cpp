@@ -0,0 +1,480 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../AI/AI.h"
+#include "../Chess/AttackTables.h"
+#include "../Chess/ChessBoard.h"
+#include "../Chess/MoveGen.h"
+#include "../Utils/Allocations.h"
+
+namespace {
+
+// Puts back the flags and precision of std::cout when a table row is done, the search prints its scores after it
+class CoutFormatGuard {
+public:
+    CoutFormatGuard() : flags(std::cout.flags()), precision(std::cout.precision()) {}
+    ~CoutFormatGuard() {
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    CoutFormatGuard(const CoutFormatGuard&) = delete;
+    CoutFormatGuard& operator=(const CoutFormatGuard&) = delete;
+
+private:
+    std::ios::fmtflags flags;
+    std::streamsize precision;
+};
+
+struct SliderSample {
+    int sq;
+    uint64_t occupied;
+};
+
+// Chained lookups feed the running sum back into the input, measuring latency instead of throughput
+template <typename Lookup>
+double nsPerLookup(const std::vector<SliderSample>& samples, int rounds, uint64_t& checksum, Lookup lookup,
+                   bool chained = false) {
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t sum = 0;
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& s : samples) {
+            sum += lookup(s.sq, chained ? s.occupied ^ (sum & 0xFF) : s.occupied);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    checksum = sum;
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / (static_cast<double>(rounds) * samples.size());
+}
+
+void printResult(const std::string& name, double ns, double baseline, uint64_t checksum,
+                 const std::string& unit = "lookup") {
+    CoutFormatGuard guard;
+    std::cout << "  " << std::left << std::setw(15) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << ns << " ns/" << unit << std::setw(8) << baseline / ns << "x"
+              << "  checksum " << std::hex << checksum << "\n";
+}
+
+void benchSliders() {
+    constexpr int SAMPLES = 4096;
+    constexpr int ROUNDS = 500;
+
+    // Roughly middlegame density: each square occupied with a 25% chance
+    std::mt19937_64 rng(42);
+    std::vector<SliderSample> samples(SAMPLES);
+    for (auto& s : samples) {
+        s.sq = static_cast<int>(rng() & 63);
+        s.occupied = rng() & rng();
+    }
+
+    auto rays = [](int sq, uint64_t occ) { return rookRayMoves(sq, occ) | bishopRayMoves(sq, occ); };
+
+    auto magicTables = std::make_unique<SliderAttacks>(SliderIndexing::MAGIC);
+    auto magic = [&](int sq, uint64_t occ) {
+        return rookAttacks<SliderIndexing::MAGIC>(*magicTables, sq, occ) |
+               bishopAttacks<SliderIndexing::MAGIC>(*magicTables, sq, occ);
+    };
+
+    std::cout << "Slider attacks (rook + bishop per lookup, " << SAMPLES * ROUNDS << " lookups)\n";
+
+    uint64_t checksum = 0;
+    double baseline = nsPerLookup(samples, ROUNDS, checksum, rays);
+    printResult("rays", baseline, baseline, checksum);
+
+    double ns = nsPerLookup(samples, ROUNDS, checksum, magic);
+    printResult("magic", ns, baseline, checksum);
+
+    if (sliderIndexingSupported(SliderIndexing::PEXT)) {
+        auto pextTables = std::make_unique<SliderAttacks>(SliderIndexing::PEXT);
+        auto pext = [&](int sq, uint64_t occ) {
+            return rookAttacks<SliderIndexing::PEXT>(*pextTables, sq, occ) |
+                   bishopAttacks<SliderIndexing::PEXT>(*pextTables, sq, occ);
+        };
+
+        ns = nsPerLookup(samples, ROUNDS, checksum, pext);
+        printResult("pext", ns, baseline, checksum);
+    } else {
+        std::cout << "  pext    not supported by this CPU\n";
+    }
+}
+
+void benchBits() {
+    constexpr int SAMPLES = 4096;
+    constexpr int ROUNDS = 2000;
+
+    std::cout << "Bit utilities (popcnt " << (CPU_FEATURES.popcnt ? "yes" : "no") << ", bmi2 "
+              << (CPU_FEATURES.bmi2 ? "yes" : "no") << ", fast pext " << (CPU_FEATURES.fastPext ? "yes" : "no")
+              << ")\n";
+
+    std::mt19937_64 rng(7);
+    std::vector<SliderSample> samples(SAMPLES);
+    for (auto& s : samples) {
+        s.sq = static_cast<int>(rng() & 63);
+        s.occupied = rng() & rng();
+    }
+
+    auto swar = [](int, uint64_t x) { return popcountSoftware(x); };
+    auto hardware = [](int, uint64_t x) { return popcount(x); };
+
+    uint64_t checksum = 0;
+    double baseline = nsPerLookup(samples, ROUNDS, checksum, swar, true);
+    printResult("swar", baseline, baseline, checksum);
+
+    double ns = nsPerLookup(samples, ROUNDS, checksum, hardware, true);
+    printResult("popcount", ns, baseline, checksum);
+
+    auto pextSw = [](int sq, uint64_t x) { return pextSoftware(x, SLIDER_ATTACKS.rook[sq].mask); };
+    auto pextHw = [](int sq, uint64_t x) { return pext(x, SLIDER_ATTACKS.rook[sq].mask); };
+
+    baseline = nsPerLookup(samples, ROUNDS, checksum, pextSw, true);
+    printResult("pext sw", baseline, baseline, checksum);
+
+    ns = nsPerLookup(samples, ROUNDS, checksum, pextHw, true);
+    printResult("pext", ns, baseline, checksum);
+}
+
+// Plays moves given as "e2e4" strings
+void playMoves(ChessBoard& board, const std::vector<std::string>& moves) {
+    for (const auto& m : moves) {
+        board.movePiece(Move((m[0] - 'a') + ('8' - m[1]) * 8, (m[2] - 'a') + ('8' - m[3]) * 8));
+    }
+}
+
+void benchMoveGen() {
+    constexpr int ROUNDS = 200000;
+
+    const std::vector<std::pair<std::string, std::vector<std::string>>> positions = {
+        {"start", {}},
+        {"italian", {"e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "g8f6"}},
+        {"open", {"e2e4", "d7d5", "e4d5", "d8d5", "b1c3", "d5a5", "d2d4", "c7c6", "g1f3", "c8f5"}},
+    };
+
+    std::cout << "Move generation\n";
+
+    for (const auto& [name, line] : positions) {
+        ChessBoard board;
+        playMoves(board, line);
+        const Position& position = board.getPosition();
+
+        auto timeGen = [&](const std::string& label, double baseline, auto&& generate) {
+            uint64_t checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < ROUNDS; ++r) {
+                checksum += generate();
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+
+            double ns = std::chrono::duration<double, std::nano>(elapsed).count() / double(checksum);
+            printResult(name + " " + label, ns, baseline > 0 ? baseline : ns, checksum / ROUNDS, "move");
+            return ns;
+        };
+
+        // pseudo-legal targets per piece, what the search generated before
+        double baseline = timeGen("pseudo", 0, [&] {
+            MoveList moves;
+            uint64_t own = position.getColorBitboard(position.isWhiteToMove());
+            for (uint64_t pieces = own; pieces; pieces &= pieces - 1) {
+                int from = ctz(pieces);
+                for (uint64_t targets = position.getPseudoLegalMoves(from); targets; targets &= targets - 1) {
+                    moves.push_back(Move(from, ctz(targets)));
+                }
+            }
+            return moves.size();
+        });
+
+        timeGen("legal", baseline, [&] { return MoveList(position).size(); });
+    }
+}
+
+void benchMakeMove() {
+    constexpr int ROUNDS = 20000;
+
+    ChessBoard board;
+    playMoves(board, {"e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "g8f6"});
+    const Position root = board.getPosition();
+
+    MoveList moves(root);
+
+    std::cout << "Make move (" << moves.size() << " moves, Position is " << sizeof(Position) << " bytes, Move is "
+              << sizeof(Move) << ")\n";
+
+    auto timeMoves = [&](const std::string& name, double baseline, auto&& makeAndHash) {
+        uint64_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; ++r) {
+            for (Move move : moves) {
+                checksum += makeAndHash(move);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (double(ROUNDS) * moves.size());
+        printResult(name, ns, baseline > 0 ? baseline : ns, checksum, "move");
+        return ns;
+    };
+
+    // validated movePiece on a copy, what the UI uses
+    double baseline = timeMoves("copy", 0, [&](Move m) {
+        Position child = root;
+        child.movePiece(m);
+        return child.getHash();
+    });
+
+    // unchecked makeMove, restored either from the undo stack or by copying
+    ChessBoard searchBoard(root);
+    timeMoves("unmake", baseline, [&](Move m) {
+        searchBoard.makeMove(m);
+        uint64_t hash = searchBoard.getBoardHash();
+        searchBoard.unmakeMove();
+        return hash;
+    });
+
+    timeMoves("copymake", baseline, [&](Move m) {
+        Position child = root;
+        UndoState undo;
+        child.makeMove(m, undo);
+        return child.getHash();
+    });
+}
+
+// Returns the heap allocations made inside the search, which should stay at 0. Only builds configured with
+// COUNT_ALLOCATIONS count them.
+uint64_t benchSearch() {
+    constexpr int DEPTH = 6;
+
+    struct SearchPosition {
+        std::string name;
+        std::vector<std::string> moves;
+        bool whiteToMove;
+    };
+
+    const std::vector<SearchPosition> positions = {
+        {"start", {}, true},
+        {"italian", {"e2e4", "e7e5", "g1f3", "b8c6", "f1c4"}, false},
+    };
+
+    std::cout << "Search (depth " << DEPTH << (ALLOCATIONS_COUNTED ? "" : ", allocations not counted in this build")
+              << ")\n";
+
+    uint64_t allocations = 0;
+
+    for (const auto& p : positions) {
+        ChessBoard board;
+        playMoves(board, p.moves);
+
+        AI ai(DEPTH, 1000000, 16, 1, LAZY_SMP);
+
+        auto start = std::chrono::steady_clock::now();
+        ai.findBestMove(&board, p.whiteToMove);
+        auto end = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        int64_t nodes = ai.getEvaluatedMoves();
+        uint64_t searchAllocations = ai.getSearchAllocations();
+        allocations += searchAllocations;
+
+        CoutFormatGuard guard;
+        std::cout << "  " << std::left << std::setw(9) << p.name << std::right << std::setw(10) << nodes
+                  << " nodes" << std::fixed << std::setprecision(1) << std::setw(9) << ms << " ms" << std::setw(10)
+                  << static_cast<int64_t>(nodes / (ms / 1000.0)) << " nps";
+        if (ALLOCATIONS_COUNTED) std::cout << std::setw(6) << searchAllocations << " allocs";
+        std::cout << "\n";
+    }
+
+    return allocations;
+}
+
+// Time to a fixed depth and node rate of every parallel mode, from one thread up to maxThreads
+void benchThreads(int maxThreads) {
+    constexpr int DEPTH = 7;
+
+    struct SearchPosition {
+        std::vector<std::string> moves;
+        bool whiteToMove;
+    };
+
+    const std::vector<SearchPosition> positions = {
+        {{}, true},
+        {{"e2e4", "e7e5", "g1f3", "b8c6", "f1c4"}, false},
+        {{"d2d4", "d7d5", "c2c4", "e7e6", "b1c3", "g8f6", "c1g5", "f8e7"}, true},
+    };
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    std::cout << "Threads (depth " << DEPTH << ", " << positions.size() << " positions)\n";
+
+    for (SearchMode mode : {ROOT_SPLIT, LAZY_SMP, YBWC}) {
+        double baseMs = 0;
+        double baseNps = 0;
+
+        for (int threads : threadCounts) {
+            double ms = 0;
+            int64_t nodes = 0;
+
+            for (const auto& p : positions) {
+                ChessBoard board;
+                playMoves(board, p.moves);
+                AI ai(DEPTH, 1000000, 16, threads, mode);
+
+                // The search reports every iteration, keep the table readable
+                std::streambuf* out = std::cout.rdbuf(nullptr);
+                auto start = std::chrono::steady_clock::now();
+                ai.findBestMove(&board, p.whiteToMove);
+                auto end = std::chrono::steady_clock::now();
+                std::cout.rdbuf(out);
+                std::cout.clear();
+
+                ms += std::chrono::duration<double, std::milli>(end - start).count();
+                nodes += ai.getEvaluatedMoves();
+            }
+
+            double nps = nodes / (ms / 1000.0);
+            if (threads == 1) {
+                baseMs = ms;
+                baseNps = nps;
+            }
+
+            CoutFormatGuard guard;
+            std::cout << "  " << std::left << std::setw(9) << searchModeToString(mode) << std::right << std::setw(3)
+                      << threads << " threads" << std::setw(11) << nodes << " nodes" << std::fixed
+                      << std::setprecision(1) << std::setw(9) << ms << " ms" << std::setw(10)
+                      << static_cast<int64_t>(nps) << " nps" << std::setprecision(2) << std::setw(7)
+                      << baseMs / ms << "x time" << std::setw(7) << nps / baseNps << "x nps\n";
+        }
+    }
+}
+
+// Nodes and time to a fixed depth with all of the selective search, and with each technique turned off in turn
+void benchPruning() {
+    constexpr int DEPTH = 8;
+
+    struct SearchPosition {
+        std::vector<std::string> moves;
+        bool whiteToMove;
+    };
+
+    const std::vector<SearchPosition> positions = {
+        {{}, true},
+        {{"e2e4", "e7e5", "g1f3", "b8c6", "f1c4"}, false},
+        {{"d2d4", "d7d5", "c2c4", "e7e6", "b1c3", "g8f6", "c1g5", "f8e7"}, true},
+    };
+
+    const std::vector<std::pair<std::string, PruningOptions>> variants = {
+        {"all", {}},
+        {"no null", {false, true, true, true}},
+        {"no lmr", {true, false, true, true}},
+        {"no futility", {true, true, false, true}},
+        {"no reverse", {true, true, true, false}},
+        {"none", {false, false, false, false}},
+    };
+
+    std::cout << "Pruning (depth " << DEPTH << ", " << positions.size() << " positions)\n";
+
+    double baseMs = 0;
+    for (const auto& [name, options] : variants) {
+        double ms = 0;
+        int64_t nodes = 0;
+        std::string moves;
+
+        for (const auto& p : positions) {
+            ChessBoard board;
+            playMoves(board, p.moves);
+            AI ai(DEPTH, 1000000, 16, 1, LAZY_SMP);
+            ai.setPruning(options);
+
+            // The search reports every iteration, keep the table readable
+            std::streambuf* out = std::cout.rdbuf(nullptr);
+            auto start = std::chrono::steady_clock::now();
+            Move best = ai.findBestMove(&board, p.whiteToMove);
+            auto end = std::chrono::steady_clock::now();
+            std::cout.rdbuf(out);
+            std::cout.clear();
+
+            ms += std::chrono::duration<double, std::milli>(end - start).count();
+            nodes += ai.getEvaluatedMoves();
+            moves += ' ' + moveToString(best);
+        }
+
+        if (baseMs == 0) baseMs = ms;
+
+        CoutFormatGuard guard;
+        std::cout << "  " << std::left << std::setw(12) << name << std::right << std::setw(11) << nodes << " nodes"
+                  << std::fixed << std::setprecision(1) << std::setw(9) << ms << " ms" << std::setprecision(2)
+                  << std::setw(7) << ms / baseMs << "x time  best" << moves << "\n";
+    }
+}
+
+}  // namespace
+
+int runBench(int argc, char* argv[]) {
+    std::string name = argc > 0 ? argv[0] : "all";
+
+    bool ran = false;
+
+    if (name == "all" || name == "sliders") {
+        benchSliders();
+        ran = true;
+    }
+
+    if (name == "all" || name == "bits") {
+        benchBits();
+        ran = true;
+    }
+
+    if (name == "all" || name == "movegen") {
+        benchMoveGen();
+        ran = true;
+    }
+
+    if (name == "all" || name == "makemove") {
+        benchMakeMove();
+        ran = true;
+    }
+
+    if (name == "all" || name == "search") {
+        ran = true;
+        if (benchSearch() != 0) {
+            std::cerr << "search allocated on the heap\n";
+            return 1;
+        }
+    }
+
+    // Slow, so not part of all
+    if (name == "threads") {
+        int maxThreads = argc > 1 ? std::stoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+        benchThreads(std::max(1, maxThreads));
+        ran = true;
+    }
+
+    // Slow as well
+    if (name == "pruning") {
+        benchPruning();
+        ran = true;
+    }
+
+    if (!ran) {
+        std::cerr << "Unknown benchmark " << name
+                  << ", expected one of: all, sliders, bits, movegen, makemove, search, threads [max threads], "
+                     "pruning\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Micro-benchmarks for the engine hot paths, run with `ChessGame bench [name]`
+int runBench(int argc, char* argv[]);
@@ -0,0 +1,255 @@
+#include "Perft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Chess/MoveGen.h"
+#include "../Chess/Position.h"
+#include "../Thread/ThreadPool.h"
+
+namespace {
+
+// Shared by all threads without locks, an entry torn by a concurrent store fails the key check and counts as a miss
+class PerftTable {
+public:
+    explicit PerftTable(size_t megabytes) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= (megabytes << 20)) count *= 2;
+
+        entries = std::make_unique<Entry[]>(count);
+        mask = count - 1;
+    }
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const {
+        const Entry& entry = entries[key & mask];
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) != key || static_cast<int>(data >> DEPTH_SHIFT) != depth) return false;
+        nodes = data & NODES_MASK;
+        return true;
+    }
+
+    void store(uint64_t key, int depth, uint64_t nodes) {
+        Entry& entry = entries[key & mask];
+        uint64_t data = (static_cast<uint64_t>(depth) << DEPTH_SHIFT) | nodes;
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    // depth in the top byte, the node count below it
+    static constexpr int DEPTH_SHIFT = 56;
+    static constexpr uint64_t NODES_MASK = (1ULL << DEPTH_SHIFT) - 1;
+
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    uint64_t mask;
+};
+
+uint64_t perft(Position& position, int depth, PerftTable* table) {
+    uint64_t nodes = 0;
+    if (table && depth > 1 && table->probe(position.getHash(), depth, nodes)) return nodes;
+
+    MoveList moves(position);
+
+    // Bulk counting, the last ply only needs the number of legal moves
+    if (depth == 1) return moves.size();
+
+    for (Move move : moves) {
+        UndoState undo;
+        position.makeMove(move, undo);
+        nodes += perft(position, depth - 1, table);
+        position.unmakeMove(undo);
+    }
+
+    if (table) table->store(position.getHash(), depth, nodes);
+    return nodes;
+}
+
+struct PerftOptions {
+    size_t hashMegabytes = 0;
+    bool parallel = false;
+};
+
+struct DivideResult {
+    std::vector<std::pair<std::string, uint64_t>> moves;
+    uint64_t nodes = 0;
+    double ms = 0;
+};
+
+// Counts below every root move, spreading the root moves over a ThreadPool in parallel mode
+DivideResult divide(const Position& root, int depth, const PerftOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<PerftTable> table;
+    if (options.hashMegabytes > 0) table = std::make_unique<PerftTable>(options.hashMegabytes);
+
+    MoveList moves(root);
+    size_t count = moves.size();
+
+    std::vector<uint64_t> counts(count);
+    auto countMove = [&](size_t i) {
+        Position child = root;
+        UndoState undo;
+        child.makeMove(moves[i], undo);
+        counts[i] = depth > 1 ? perft(child, depth - 1, table.get()) : 1;
+    };
+
+    if (options.parallel) {
+        ThreadPool pool;
+        for (size_t i = 0; i < count; ++i) {
+            pool.submit([&countMove, i]() { countMove(i); });
+        }
+        pool.join();
+    } else {
+        for (size_t i = 0; i < count; ++i) countMove(i);
+    }
+
+    DivideResult result;
+    for (size_t i = 0; i < count; ++i) {
+        result.moves.emplace_back(moveToString(moves[i]), counts[i]);
+        result.nodes += counts[i];
+    }
+    std::sort(result.moves.begin(), result.moves.end());
+
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+int64_t nodesPerSecond(uint64_t nodes, double ms) {
+    return ms > 0 ? static_cast<int64_t>(nodes / (ms / 1000.0)) : 0;
+}
+
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    // expected node counts, index 0 is depth 1
+    std::vector<uint64_t> expected;
+};
+
+// The usual reference positions, with counts from the Chess Programming Wiki perft results page
+const std::vector<PerftCase> PERFT_SUITE = {
+    {"start", Position::START_FEN, {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690}},
+    {"pos3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+    {"pos4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"pos4-mirror", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"pos5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487, 89941194}},
+    {"pos6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551}},
+};
+
+int runSuite(int maxDepth, const PerftOptions& options) {
+    std::cout << "Perft suite (max depth " << maxDepth << ")\n";
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalMs = 0;
+
+    for (const auto& test : PERFT_SUITE) {
+        Position position;
+        position.setFromFen(test.fen);
+
+        int depth = std::min<int>(maxDepth, test.expected.size());
+        uint64_t expected = test.expected[depth - 1];
+        DivideResult result = divide(position, depth, options);
+
+        bool ok = result.nodes == expected;
+        failures += !ok;
+        totalNodes += result.nodes;
+        totalMs += result.ms;
+
+        std::cout << "  " << std::left << std::setw(12) << test.name << std::right << " depth " << depth
+                  << std::setw(12) << result.nodes << std::fixed << std::setprecision(1) << std::setw(10)
+                  << result.ms << " ms" << std::setw(12) << nodesPerSecond(result.nodes, result.ms) << " nps  "
+                  << (ok ? "ok" : "FAIL, expected " + std::to_string(expected)) << "\n"
+                  << std::defaultfloat;
+    }
+
+    std::cout << "Total " << totalNodes << " nodes, " << std::fixed << std::setprecision(1) << totalMs << " ms, "
+              << nodesPerSecond(totalNodes, totalMs) << " nps, " << failures << " failed\n"
+              << std::defaultfloat;
+
+    return failures ? 1 : 0;
+}
+
+int runDivide(const Position& position, int depth, const PerftOptions& options) {
+    std::cout << position.toFen() << "\n";
+
+    DivideResult result = divide(position, depth, options);
+    for (const auto& [move, nodes] : result.moves) {
+        std::cout << move << ": " << nodes << "\n";
+    }
+
+    std::cout << "\nNodes: " << result.nodes << "\nTime: " << std::fixed << std::setprecision(1) << result.ms
+              << " ms\nNPS: " << nodesPerSecond(result.nodes, result.ms) << "\n"
+              << std::defaultfloat;
+    return 0;
+}
+
+void printUsage() {
+    std::cerr << "usage: ChessGame perft [suite [max depth] | depth [fen]] [--hash MB] [--parallel]\n";
+}
+
+}  // namespace
+
+int runPerft(int argc, char* argv[]) {
+    PerftOptions options;
+    std::vector<std::string> args;
+
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--parallel") {
+            options.parallel = true;
+        } else if (arg == "--hash" && i + 1 < argc) {
+            options.hashMegabytes = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty() || args[0] == "suite") {
+        int maxDepth = args.size() > 1 ? std::atoi(args[1].c_str()) : 5;
+        if (maxDepth < 1) {
+            printUsage();
+            return 1;
+        }
+        return runSuite(maxDepth, options);
+    }
+
+    int depth = std::atoi(args[0].c_str());
+    if (depth < 1) {
+        printUsage();
+        return 1;
+    }
+
+    // The FEN may arrive quoted as one argument or split on its spaces
+    std::string fen;
+    for (size_t i = 1; i < args.size(); ++i) {
+        fen += (i > 1 ? " " : "") + args[i];
+    }
+
+    Position position;
+    if (!position.setFromFen(fen.empty() ? Position::START_FEN : fen)) {
+        std::cerr << "Invalid FEN: " << fen << "\n";
+        return 1;
+    }
+
+    return runDivide(position, depth, options);
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Move generator node counts, run with `ChessGame perft [suite | depth [fen]] [--hash MB] [--parallel]`
+int runPerft(int argc, char* argv[]);
@@ -0,0 +1,121 @@
+#include "SelfTest.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../AI/AI.h"
+#include "../AI/OpeningBook.h"
+#include "../AI/TranspositionTable.h"
+#include "../Chess/MoveGen.h"
+#include "../Chess/Position.h"
+
+namespace {
+
+struct PlyCase {
+    const char* fen;
+    float score;  // relative to the root, as the search returns it at storePly
+    int storePly;
+    int probePly;
+};
+
+// Published with the Polyglot book format, the key after each line of moves from the starting position
+struct KeyCase {
+    const char* moves;
+    uint64_t key;
+};
+
+constexpr KeyCase POLYGLOT_KEYS[] = {
+    {"", 0x463B96181691FC9CULL},
+    {"e2e4", 0x823C9B50FD114196ULL},
+    {"e2e4 d7d5", 0x0756B94461C50FB0ULL},
+    {"e2e4 d7d5 e4e5", 0x662FAFB965DB29D4ULL},
+    {"e2e4 d7d5 e4e5 f7f5", 0x22A48B5A8E47FF78ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2", 0x652A607CA3F242C1ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00FDD303C946BDD9ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4", 0x3C8123EA7B067637ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5C3F9B829B279560ULL},
+};
+
+// False if a move is not legal in the position reached so far
+bool playMoves(Position& position, const std::string& moves) {
+    std::istringstream stream(moves);
+    std::string text;
+    while (stream >> text) {
+        Move played = Move::none();
+        for (Move move : MoveList(position)) {
+            if (moveToString(move) == text) played = move;
+        }
+        if (played == Move::none()) return false;
+
+        UndoState undo;
+        position.makeMove(played, undo);
+    }
+    return true;
+}
+
+int checkPolyglotKeys() {
+    std::cout << "Polyglot keys\n";
+
+    int failures = 0;
+    for (const auto& test : POLYGLOT_KEYS) {
+        Position position;
+        position.setFromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+        bool ok = playMoves(position, test.moves);
+        uint64_t key = ok ? OpeningBook::polyglotKey(position) : 0;
+        ok = ok && key == test.key;
+        failures += !ok;
+
+        std::ostringstream expected;
+        expected << std::hex << std::setfill('0') << std::setw(16) << test.key;
+        std::cout << "  " << std::left << std::setw(36) << (*test.moves ? test.moves : "start") << std::right
+                  << std::hex << std::setfill('0') << std::setw(16) << key << std::dec << std::setfill(' ') << "  "
+                  << (ok ? "ok" : "FAIL, expected " + expected.str()) << "\n";
+    }
+    return failures;
+}
+
+}  // namespace
+
+// A tablebase or mate score stored at one ply and read back at another must be what the search would return there:
+// the end is as far from the position as before, so the score moves by the plies between
+int runSelfTest(int /*argc*/, char* /*argv*/[]) {
+    // The same KQK position with each side to move, and a mate for comparison
+    const PlyCase cases[] = {
+        {"8/8/8/4k3/8/8/8/4K2Q w - - 0 1", AI::TB_WIN_SCORE - 3, 3, 9},
+        {"8/8/8/4k3/8/8/8/4K2Q w - - 0 1", AI::TB_WIN_SCORE - 9, 9, 3},
+        {"8/8/8/4k3/8/8/8/4K2Q b - - 0 1", -(AI::TB_WIN_SCORE - 4), 4, 10},
+        {"8/8/8/4k3/8/8/8/4K2Q b - - 0 1", -(AI::TB_WIN_SCORE - 10), 10, 4},
+        {"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", AI::MATE_SCORE - 5, 4, 8},
+    };
+
+    std::cout << "TT scores across plies\n";
+    int failures = 0;
+    for (const auto& test : cases) {
+        Position position;
+        position.setFromFen(test.fen);
+
+        TranspositionTable table(1);
+        table.store(position.getHash(), Move::none(), AI::scoreToTT(test.score, test.storePly), 1, BOUND_EXACT);
+
+        TTData entry;
+        bool found = table.probe(position.getHash(), entry);
+        float score = found ? AI::scoreFromTT(entry.score, test.probePly) : 0.0f;
+
+        float shift = static_cast<float>(test.probePly - test.storePly);
+        float expected = test.score > 0 ? test.score - shift : test.score + shift;
+
+        bool ok = found && score == expected && AI::isDecisive(score);
+        failures += !ok;
+        std::cout << "  " << test.fen << "  ply " << test.storePly << " -> " << test.probePly << "  " << score << "  "
+                  << (ok ? "ok" : "FAIL, expected " + std::to_string(static_cast<int>(expected))) << "\n";
+    }
+
+    failures += checkPolyglotKeys();
+
+    std::cout << failures << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Checks of engine internals that perft and bench do not reach, run with `ChessGame test`
+int runSelfTest(int argc, char* argv[]);
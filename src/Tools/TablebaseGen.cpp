@@ -0,0 +1,437 @@
+#include "TablebaseGen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../AI/Tablebase.h"
+#include "../Chess/AttackTables.h"
+#include "../Thread/ThreadPool.h"
+#include "../Utils/bits.h"
+
+namespace {
+
+// Working values: undecided, illegal, or plies to mate + 1, won when white is to move and lost when black is
+constexpr uint8_t UNDECIDED = 0;
+constexpr uint8_t ILLEGAL = 0xFF;
+
+// Black's captures only ever leave a lone minor piece or nothing, so they are all draws and every table stands on
+// its own. Pawns come after the tables they promote into.
+const std::vector<TablebaseMaterial> TABLEBASE_SETS = {
+    {1, {QUEEN, EMPTY}}, {1, {ROOK, EMPTY}}, {1, {PAWN, EMPTY}}, {2, {BISHOP, KNIGHT}}, {2, {BISHOP, BISHOP}},
+};
+
+constexpr PieceType PROMOTIONS[4] = {QUEEN, ROOK, BISHOP, KNIGHT};
+
+struct TablebasePosition {
+    bool whiteToMove;
+    int whiteKing;
+    int blackKing;
+    int squares[TB_MAX_PIECES];
+};
+
+int pieceOrder(PieceType type) {
+    return static_cast<int>(std::find(std::begin(TB_PIECE_ORDER), std::end(TB_PIECE_ORDER), type) -
+                            std::begin(TB_PIECE_ORDER));
+}
+
+uint64_t bit(int sq) { return 1ULL << sq; }
+
+/*
+ * One table, solved backwards from the mates: white wins in n plies if some move reaches a black position lost in
+ * n - 1, and black loses in n plies once every one of its moves reaches a white win, the last of them in n - 1. Each
+ * pass retracts the moves into the positions decided by the pass before, spread over the pool in chunks of indices.
+ * Black positions count down their moves still to be refuted, so a pass never has to look forward.
+ */
+class Generator {
+public:
+    Generator(const TablebaseMaterial& material, ThreadPool& pool, int chunks,
+              const std::vector<std::unique_ptr<Generator>>& built)
+        : material(material), size(tablebaseSize(material.count)), pool(pool), chunks(chunks), built(built) {}
+
+    void generate();
+    bool write(const std::string& directory) const;
+
+    const TablebaseMaterial& getMaterial() const { return material; }
+    uint8_t getValue(size_t index) const { return values[index].load(std::memory_order_relaxed); }
+
+    uint64_t legal = 0;
+    uint64_t wins = 0;
+    uint64_t losses = 0;
+    int longest = 0;
+    int passes = 0;
+    double ms = 0;
+
+private:
+    const TablebaseMaterial material;
+    const size_t size;
+    ThreadPool& pool;
+    const int chunks;
+
+    // Earlier tables, for promotions
+    const std::vector<std::unique_ptr<Generator>>& built;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> values;
+
+    // Black to move only, legal moves not yet known to reach a white win
+    std::unique_ptr<std::atomic<uint8_t>[]> movesLeft;
+
+    // White to move only, plies to mate through the best promotion, 0 without one
+    std::unique_ptr<uint8_t[]> promotions;
+
+    template <typename Visit>
+    uint64_t parallelFor(size_t begin, size_t end, Visit visit);
+
+    TablebasePosition decode(size_t index) const;
+    size_t encode(const TablebasePosition& position) const {
+        return tablebaseIndex(position.whiteToMove, position.whiteKing, position.blackKing, position.squares,
+                              material.count);
+    }
+
+    uint64_t getOccupied(const TablebasePosition& position) const;
+    uint64_t whiteAttacks(const TablebasePosition& position) const;
+    bool isLegal(const TablebasePosition& position) const;
+    int promotionPlies(const TablebasePosition& position) const;
+
+    uint64_t initialize(size_t index);
+    uint64_t retractWhite(size_t index, uint8_t value);
+    uint64_t retractBlack(size_t index, uint8_t value);
+
+    template <typename Entry>
+    bool writeFile(const std::string& path, const char* magic, int bits, Entry entry) const;
+};
+
+template <typename Visit>
+uint64_t Generator::parallelFor(size_t begin, size_t end, Visit visit) {
+    std::atomic<uint64_t> total = 0;
+    size_t chunk = (end - begin + chunks - 1) / chunks;
+
+    for (size_t first = begin; first < end; first += chunk) {
+        size_t last = std::min(end, first + chunk);
+        pool.submit([&visit, &total, first, last]() {
+            uint64_t count = 0;
+            for (size_t index = first; index < last; ++index) count += visit(index);
+            total += count;
+        });
+    }
+    pool.join();
+    return total;
+}
+
+TablebasePosition Generator::decode(size_t index) const {
+    TablebasePosition position;
+    for (int i = material.count - 1; i >= 0; --i) {
+        position.squares[i] = static_cast<int>(index & 63);
+        index >>= 6;
+    }
+    position.blackKing = static_cast<int>(index & 63);
+    index >>= 6;
+    position.whiteKing = static_cast<int>((index & 31) / 4 * 8 + (index & 3));
+    position.whiteToMove = (index >> 5) == 0;
+    return position;
+}
+
+uint64_t Generator::getOccupied(const TablebasePosition& position) const {
+    uint64_t occupied = bit(position.whiteKing) | bit(position.blackKing);
+    for (int i = 0; i < material.count; ++i) occupied |= bit(position.squares[i]);
+    return occupied;
+}
+
+// The black king is left out of the occupancy, so it cannot step back along a slider's ray
+uint64_t Generator::whiteAttacks(const TablebasePosition& position) const {
+    uint64_t occupied = getOccupied(position) & ~bit(position.blackKing);
+    uint64_t attacks = ATTACK_TABLES.king[position.whiteKing];
+    for (int i = 0; i < material.count; ++i) {
+        attacks |= pieceAttacks(material.pieces[i], true, position.squares[i], occupied);
+    }
+    return attacks;
+}
+
+bool Generator::isLegal(const TablebasePosition& position) const {
+    if (ATTACK_TABLES.king[position.whiteKing] & bit(position.blackKing)) return false;
+    if (position.whiteKing == position.blackKing) return false;
+
+    uint64_t occupied = bit(position.whiteKing) | bit(position.blackKing);
+    for (int i = 0; i < material.count; ++i) {
+        int sq = position.squares[i];
+        if ((occupied & bit(sq)) || (material.pieces[i] == PAWN && (sq < 8 || sq >= 56))) return false;
+        occupied |= bit(sq);
+    }
+
+    // Black has nothing to give check with, but must not be left in check itself
+    return !position.whiteToMove || !(whiteAttacks(position) & bit(position.blackKing));
+}
+
+// Promotions leave this table, their plies come from the tables built before
+int Generator::promotionPlies(const TablebasePosition& position) const {
+    uint64_t occupied = getOccupied(position);
+    int best = 0;
+
+    for (int i = 0; i < material.count; ++i) {
+        int to = position.squares[i] - 8;
+        if (material.pieces[i] != PAWN || to >= 8 || (occupied & bit(to))) continue;
+
+        for (PieceType promotion : PROMOTIONS) {
+            TablebaseMaterial child = material;
+            TablebasePosition after = position;
+            after.whiteToMove = false;
+            child.pieces[i] = promotion;
+            after.squares[i] = to;
+            if (child.count == 2 && pieceOrder(child.pieces[1]) < pieceOrder(child.pieces[0])) {
+                std::swap(child.pieces[0], child.pieces[1]);
+                std::swap(after.squares[0], after.squares[1]);
+            }
+            if (child.isDrawn()) continue;
+
+            auto table = std::find_if(built.begin(), built.end(), [&](const auto& t) { return t->material == child; });
+            if (table == built.end()) continue;
+
+            // Lost for black in value - 1 plies
+            uint8_t value = (*table)->getValue(tablebaseIndex(false, after.whiteKing, after.blackKing, after.squares,
+                                                              child.count));
+            if (value != UNDECIDED && value != ILLEGAL && (best == 0 || value < best)) best = value;
+        }
+    }
+    return best;
+}
+
+uint64_t Generator::initialize(size_t index) {
+    TablebasePosition position = decode(index);
+    if (!isLegal(position)) {
+        values[index].store(ILLEGAL, std::memory_order_relaxed);
+        return 0;
+    }
+
+    if (position.whiteToMove) {
+        if (promotions) promotions[index] = static_cast<uint8_t>(promotionPlies(position));
+        return 1;
+    }
+
+    uint64_t attacks = whiteAttacks(position);
+    uint64_t moves = ATTACK_TABLES.king[position.blackKing] & ~attacks;
+    movesLeft[index - size / 2].store(static_cast<uint8_t>(popcount(moves)), std::memory_order_relaxed);
+
+    // Mated
+    if (!moves && (attacks & bit(position.blackKing))) values[index].store(1, std::memory_order_relaxed);
+    return 1;
+}
+
+// Every white position with a move to this lost one wins a ply later, unless it already wins sooner
+uint64_t Generator::retractWhite(size_t index, uint8_t value) {
+    TablebasePosition position = decode(index);
+    position.whiteToMove = true;
+    uint64_t occupied = getOccupied(position);
+    uint64_t decided = 0;
+
+    auto decide = [&](const TablebasePosition& before) {
+        uint8_t expected = UNDECIDED;
+        decided += values[encode(before)].compare_exchange_strong(expected, static_cast<uint8_t>(value + 1),
+                                                                   std::memory_order_relaxed);
+    };
+
+    TablebasePosition before = position;
+    uint64_t kingFrom = ATTACK_TABLES.king[position.whiteKing] & ~occupied & ~ATTACK_TABLES.king[position.blackKing];
+    for (; kingFrom; kingFrom &= kingFrom - 1) {
+        before.whiteKing = static_cast<int>(ctz(kingFrom));
+        decide(before);
+    }
+    before.whiteKing = position.whiteKing;
+
+    for (int i = 0; i < material.count; ++i) {
+        int to = position.squares[i];
+        uint64_t from = 0;
+        if (material.pieces[i] != PAWN) {
+            from = pieceAttacks(material.pieces[i], true, to, occupied) & ~occupied;
+        } else if (to < 48 && !(occupied & bit(to + 8))) {
+            from = bit(to + 8);
+            if (to / 8 == 4 && !(occupied & bit(to + 16))) from |= bit(to + 16);
+        }
+
+        for (; from; from &= from - 1) {
+            before.squares[i] = static_cast<int>(ctz(from));
+            decide(before);
+        }
+        before.squares[i] = to;
+    }
+    return decided;
+}
+
+// Every black position with a move to this won one has one move fewer left, and is lost once none is left
+uint64_t Generator::retractBlack(size_t index, uint8_t value) {
+    TablebasePosition before = decode(index);
+    before.whiteToMove = false;
+    uint64_t occupied = getOccupied(before);
+    uint64_t decided = 0;
+
+    uint64_t from = ATTACK_TABLES.king[before.blackKing] & ~occupied & ~ATTACK_TABLES.king[before.whiteKing];
+    for (; from; from &= from - 1) {
+        before.blackKing = static_cast<int>(ctz(from));
+        size_t previous = encode(before);
+        if (values[previous].load(std::memory_order_relaxed) != UNDECIDED) continue;
+
+        if (movesLeft[previous - size / 2].fetch_sub(1, std::memory_order_relaxed) == 1) {
+            values[previous].store(static_cast<uint8_t>(value + 1), std::memory_order_relaxed);
+            ++decided;
+        }
+    }
+    return decided;
+}
+
+void Generator::generate() {
+    auto start = std::chrono::steady_clock::now();
+    const size_t half = size / 2;
+
+    values = std::make_unique<std::atomic<uint8_t>[]>(size);
+    movesLeft = std::make_unique<std::atomic<uint8_t>[]>(half);
+    const PieceType* pieces = material.pieces + material.count;
+    bool hasPawn = std::find(material.pieces, pieces, PAWN) != pieces;
+    if (hasPawn) promotions = std::make_unique<uint8_t[]>(half);
+
+    legal = parallelFor(0, size, [this](size_t index) { return initialize(index); });
+    int lastPromotion = hasPawn ? *std::max_element(promotions.get(), promotions.get() + half) : 0;
+
+    // Pass n decides the positions mated in n plies, white's on odd passes and black's on even ones
+    for (int plies = 1;; ++plies) {
+        if (plies >= ILLEGAL - 1) {
+            std::cerr << material.getName() << ": mates longer than " << plies << " plies do not fit\n";
+            break;
+        }
+
+        auto frontier = static_cast<uint8_t>(plies);
+        uint64_t decided = 0;
+        if (plies % 2) {
+            decided = parallelFor(half, size, [this, frontier](size_t index) {
+                return getValue(index) == frontier ? retractWhite(index, frontier) : 0;
+            });
+            if (plies <= lastPromotion) {
+                decided += parallelFor(0, half, [this, plies](size_t index) {
+                    uint8_t expected = UNDECIDED;
+                    return promotions[index] == plies &&
+                           values[index].compare_exchange_strong(expected, static_cast<uint8_t>(plies + 1),
+                                                                 std::memory_order_relaxed);
+                });
+            }
+        } else {
+            decided = parallelFor(0, half, [this, frontier](size_t index) {
+                return getValue(index) == frontier ? retractBlack(index, frontier) : 0;
+            });
+        }
+
+        passes = plies;
+        if (decided == 0 && plies >= lastPromotion) break;
+    }
+
+    movesLeft.reset();
+    promotions.reset();
+
+    for (size_t index = 0; index < size; ++index) {
+        uint8_t value = getValue(index);
+        if (value == UNDECIDED || value == ILLEGAL) continue;
+        wins += index < half;
+        losses += index >= half;
+        longest = std::max(longest, value - 1);
+    }
+
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Entry>
+bool Generator::writeFile(const std::string& path, const char* magic, int bits, Entry entry) const {
+    TablebaseHeader header = {};
+    std::memcpy(header.magic, magic, 4);
+    header.version = TB_VERSION;
+    header.bits = static_cast<uint8_t>(bits);
+    header.count = static_cast<uint8_t>(material.count);
+    for (int i = 0; i < material.count; ++i) header.pieces[i] = static_cast<uint8_t>(material.pieces[i]);
+
+    // Padded by a byte, the reader always reads two
+    std::vector<uint8_t> data(sizeof(header) + (size * bits + 7) / 8 + 1);
+    std::memcpy(data.data(), &header, sizeof(header));
+    for (size_t index = 0; index < size; ++index) {
+        size_t at = index * bits;
+        unsigned window = static_cast<unsigned>(entry(index)) << (at % 8);
+        data[sizeof(header) + at / 8] |= static_cast<uint8_t>(window);
+        data[sizeof(header) + at / 8 + 1] |= static_cast<uint8_t>(window >> 8);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+bool Generator::write(const std::string& directory) const {
+    const std::string path = directory + "/" + material.getName();
+    const size_t half = size / 2;
+
+    int dtmBits = 1;
+    while ((1 << dtmBits) <= longest) ++dtmBits;
+
+    return writeFile(path + ".wdl", "TBWL", 2,
+                     [&](size_t index) {
+                         uint8_t value = getValue(index);
+                         if (value == ILLEGAL) return TB_ILLEGAL;
+                         if (value == UNDECIDED) return TB_DRAW;
+                         return index < half ? TB_WIN : TB_LOSS;
+                     }) &&
+           writeFile(path + ".dtm", "TBDM", dtmBits, [&](size_t index) {
+               uint8_t value = getValue(index);
+               return value == UNDECIDED || value == ILLEGAL ? 0 : value - 1;
+           });
+}
+
+}  // namespace
+
+int runTablebaseGen(int argc, char* argv[]) {
+    std::string directory = argc > 0 ? argv[0] : "tablebases";
+    int threads = argc > 1 ? std::stoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, threads);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    std::cout << "Tablebases into " << directory << " (" << threads << " threads)\n";
+
+    ThreadPool pool(threads);
+    std::vector<std::unique_ptr<Generator>> built;
+    uint64_t totalPositions = 0;
+    double totalMs = 0;
+
+    for (const auto& material : TABLEBASE_SETS) {
+        auto generator = std::make_unique<Generator>(material, pool, threads * 16, built);
+        generator->generate();
+
+        if (!generator->write(directory)) {
+            std::cerr << "Error: Could not write " << material.getName() << " into " << directory << "\n";
+            return 1;
+        }
+
+        size_t positions = tablebaseSize(material.count);
+        totalPositions += positions;
+        totalMs += generator->ms;
+
+        std::cout << "  " << std::left << std::setw(6) << material.getName() << std::right << std::setw(10)
+                  << generator->legal << " legal" << std::setw(10) << generator->wins << " wins" << std::setw(10)
+                  << generator->losses << " losses  longest mate " << std::setw(3) << generator->longest
+                  << " plies" << std::setw(4) << generator->passes << " passes" << std::fixed
+                  << std::setprecision(1) << std::setw(9) << generator->ms << " ms" << std::setw(11)
+                  << static_cast<int64_t>(positions / (generator->ms / 1000.0)) << " positions/s\n"
+                  << std::defaultfloat;
+
+        built.push_back(std::move(generator));
+    }
+
+    std::cout << "Total " << totalPositions << " positions, " << std::fixed << std::setprecision(1) << totalMs
+              << " ms, " << static_cast<int64_t>(totalPositions / (totalMs / 1000.0)) << " positions/s\n"
+              << std::defaultfloat;
+    return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Builds the endgame tablebases by retrograde analysis, run with `ChessGame tbgen [directory] [threads]`
+int runTablebaseGen(int argc, char* argv[]);
@@ -3,15 +3,16 @@
 #include <iostream>
 #include <thread>
 
+#include "../Chess/AttackTables.h"
 #include "../Chess/PieceType.h"
 
-void ConsoleDisplay::drawBoard(const ChessBoard &board) {
+void ConsoleDisplay::drawBoard(const Position &position) {
     for (int i = 0; i < 8; ++i) {
         std::cout << 8 - i << ' ';
         for (int j = 0; j < 8; ++j) {
-            PieceType piece = board.getPieceTypeAt(j, i);
-            bool isWhite = board.isPieceAt(j, i, true);
-            if (piece == -1) {
+            PieceType piece = position.getPieceTypeAt(j + i * 8);
+            bool isWhite = position.isWhiteAt(j + i * 8);
+            if (piece == EMPTY) {
                 // No piece at this location
                 std::cout << ' ';
             } else {
@@ -62,7 +63,7 @@ void ConsoleDisplay::drawLoop(ChessBoard &board) {
                 ai->makeMove(&board, false);
                 isCurrentPlayerWhite = true;
                 isAIThreadRunning = false;
-                drawBoard(board);
+                drawBoard(board.getPosition());
             });
 
             aiThread.detach();
@@ -85,7 +86,34 @@ bool ConsoleDisplay::makeMove(ChessBoard &board, const std::string &moveInput) {
     int toX = tolower(moveInput[2]) - 'a';
     int toY = '8' - moveInput[3];
 
-    if (board.movePiece(fromX, fromY, toX, toY)) {
+    if (!onBoard(fromX, fromY) || !onBoard(toX, toY)) {
+        std::cout << "Invalid move. Please try again." << std::endl;
+        return false;
+    }
+
+    // Optional fifth character picks the promotion piece, 'a7a8n', queen otherwise
+    PieceType promotion = QUEEN;
+    if (moveInput.size() == 5) {
+        switch (tolower(moveInput[4])) {
+            case 'q':
+                promotion = QUEEN;
+                break;
+            case 'r':
+                promotion = ROOK;
+                break;
+            case 'b':
+                promotion = BISHOP;
+                break;
+            case 'n':
+                promotion = KNIGHT;
+                break;
+            default:
+                std::cout << "Invalid promotion piece. Use q, r, b or n." << std::endl;
+                return false;
+        }
+    }
+
+    if (board.movePiece(Move(fromX + fromY * 8, toX + toY * 8, PROMOTION, promotion))) {
         return true;
     } else {
         std::cout << "Invalid move. Please try again." << std::endl;
@@ -94,13 +122,13 @@ bool ConsoleDisplay::makeMove(ChessBoard &board, const std::string &moveInput) {
 }
 
 void ConsoleDisplay::handleInput(ChessBoard &board) {
-    drawBoard(board);
+    drawBoard(board.getPosition());
     std::cout << "Player 1's turn (white): " << std::endl;
     std::string moveInputPlayer1 = receiveInput();
     while (!makeMove(board, moveInputPlayer1)) {
         moveInputPlayer1 = receiveInput();
-        drawBoard(board);
+        drawBoard(board.getPosition());
     }
     isCurrentPlayerWhite = false;
-    drawBoard(board);
+    drawBoard(board.getPosition());
 }
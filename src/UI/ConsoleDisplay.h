@@ -6,7 +6,7 @@
 class ConsoleDisplay : public IDisplay {
 public:
     ConsoleDisplay(AI* ai) : IDisplay(), ai(ai) {}
-    void drawBoard(const ChessBoard& board) override;
+    void drawBoard(const Position& position) override;
     std::string receiveInput();
     void drawLoop(ChessBoard& board) override;
     bool makeMove(ChessBoard& board, const std::string& moveInput);
@@ -43,13 +43,13 @@ void GDisplay::drawLoop(ChessBoard& board) {
             aiThread.detach();
         }
 
-        ChessBoard boardCopy;
+        Position snapshot;
         {
             std::lock_guard<std::mutex> lock(board.mtx);
-            boardCopy = board.clone();
+            snapshot = board.getPosition();
         }
 
-        drawBoard(boardCopy);
+        drawBoard(snapshot);
     }
 }
 
@@ -60,7 +60,7 @@ void GDisplay::handleInput(ChessBoard& board) {
     }
 }
 
-void GDisplay::drawBoard(const ChessBoard& board) {
+void GDisplay::drawBoard(const Position& position) {
     window.clear();
 
     // Draw ranks
@@ -79,6 +79,11 @@ void GDisplay::drawBoard(const ChessBoard& board) {
         window.draw(fileLabel);
     }
 
+    // Legal targets of the selected piece, generated once per frame instead of once per square
+    uint64_t validMoves =
+        selectedPiece.isEmpty() ? 0 : position.getValidMoves(selectedPiece.x + selectedPiece.y * 8);
+    uint64_t occupied = position.getOccupied();
+
     for (int y = 0; y < 8; ++y) {
         for (int x = 0; x < 8; ++x) {
             if ((y + x) % 2 == 0) {
@@ -87,18 +92,19 @@ void GDisplay::drawBoard(const ChessBoard& board) {
                 drawSquare(x, y, sf::Color(75, 75, 75));
             }
 
-            // if selected piece is not null, draw possible moves
-            if (!selectedPiece.isEmpty()) {
-                if (board.isSquareTaken(x, y) && board.isValidAttack(selectedPiece.x, selectedPiece.y, x, y)) {
+            // draw possible moves of the selected piece, captures in red
+            int square = x + y * 8;
+            if ((validMoves >> square) & 1) {
+                if ((occupied >> square) & 1) {
                     drawSquare(x, y, sf::Color(255, 0, 0, 100));
-                } else if (board.isValidMove(selectedPiece.x, selectedPiece.y, x, y)) {
+                } else {
                     drawCircle(x, y, 0.5, sf::Color(0, 255, 0, 100));
                 }
             }
 
             // draw piece on square
-            char piece = board.getPieceSymbol(x, y);
-            bool isWhite = board.isPieceAt(x, y, true);
+            char piece = pieceTypeToSymbol(position.getPieceTypeAt(square));
+            bool isWhite = position.isWhiteAt(square);
 
             if (piece == EMPTY_SYMBOL) continue;
 
@@ -184,6 +190,10 @@ void GDisplay::handleEvent(sf::Event& event, ChessBoard& board) {
         case sf::Event::MouseButtonPressed:
             handleMouseClick(event.mouseButton, board);
             break;
+        case sf::Event::KeyPressed:
+            // Space makes the AI move now with what it has found so far
+            if (event.key.code == sf::Keyboard::Space && isAIThreadRunning) ai->stop();
+            break;
         default:
             break;
     }
@@ -208,7 +218,7 @@ void GDisplay::handleValidChessboardClick(int colIndex, int rowIndex, ChessBoard
                                    board.isPieceAt(colIndex, rowIndex, true)};
 
     if (!selectedPiece.isEmpty() && isCurrentPlayerWhite && selectedPiece.isWhite) {
-        if (board.movePiece(selectedPiece.x, selectedPiece.y, colIndex, rowIndex)) {
+        if (board.movePiece(Move(selectedPiece.x + selectedPiece.y * 8, colIndex + rowIndex * 8))) {
             selectedPiece.clear();
             isCurrentPlayerWhite = !isCurrentPlayerWhite;
             return;
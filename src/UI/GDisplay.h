@@ -12,7 +12,7 @@ public:
     GDisplay(AI *ai);
     ~GDisplay();
 
-    void drawBoard(const ChessBoard &board) override;
+    void drawBoard(const Position &position) override;
     void drawLoop(ChessBoard &board) override;
     void handleInput(ChessBoard &board) override;
 
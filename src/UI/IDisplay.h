@@ -1,11 +1,13 @@
 #pragma once
 
 #include "../Chess/ChessBoard.h"
+#include "../Chess/Position.h"
 
 class IDisplay {
 public:
     virtual ~IDisplay() = default;
-    virtual void drawBoard(const ChessBoard& board) = 0;
+    // Draws from a snapshot, so the game's board stays free for the AI while a frame is drawn
+    virtual void drawBoard(const Position& position) = 0;
     virtual void drawLoop(ChessBoard& board) = 0;
     virtual void handleInput(ChessBoard& board) = 0;
 };
\ No newline at end of file
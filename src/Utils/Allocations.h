@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Whether this build replaces the global operator new to count allocations, see COUNT_ALLOCATIONS in CMakeLists.txt
+#if defined(COUNT_ALLOCATIONS)
+constexpr bool ALLOCATIONS_COUNTED = true;
+#else
+constexpr bool ALLOCATIONS_COUNTED = false;
+#endif
+
+// Heap allocations made so far by the calling thread, always 0 unless ALLOCATIONS_COUNTED
+uint64_t threadAllocationCount();
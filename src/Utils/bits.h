@@ -2,25 +2,134 @@
 #include <cassert>
 #include <cstdint>
 
+/*
+ * Bit utilities.
+ *
+ * Every function has a constexpr path so the attack tables can still be
+ * generated at compile time. At runtime:
+ *  - ctz / msb use the compiler builtins, which become tzcnt / lzcnt with
+ *    -mbmi / -mlzcnt and bsf / bsr otherwise (same latency, no dispatch needed)
+ *  - popcount / pext use popcnt / pext when the running CPU has them, even in
+ *    a baseline x86-64 build, and fall back to portable code otherwise
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITS_X86_DISPATCH 1
+#endif
+
+#if defined(__GNUC__)
+#define BITS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define BITS_CONSTANT_EVALUATED() true
+#endif
+
+struct CpuFeatures {
+    bool popcnt = false;
+    bool bmi2 = false;
+    // pext is microcoded on AMD before Zen 3, magic multiplication beats it there
+    bool fastPext = false;
+};
+
+inline CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if defined(BITS_X86_DISPATCH)
+    // Needed because this runs from a static initializer
+    __builtin_cpu_init();
+    features.popcnt = __builtin_cpu_supports("popcnt");
+    features.bmi2 = __builtin_cpu_supports("bmi2");
+    features.fastPext = features.bmi2 && !__builtin_cpu_is("amdfam15h") && !__builtin_cpu_is("amdfam17h");
+#endif
+    return features;
+}
+
+inline const CpuFeatures CPU_FEATURES = detectCpuFeatures();
+
 // count trailing zeros
 constexpr unsigned int ctz(uint64_t x) {
     assert(x != 0 && "ctz called with zero");
 
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
     unsigned int n = 0;
     while ((x & 1) == 0) {
         x >>= 1;
         n++;
     }
     return n;
+#endif
 }
 
 // Most significant bit
 constexpr unsigned int msb(uint64_t x) {
     assert(x != 0 && "msb called with zero");
 
+#if defined(__GNUC__)
+    return 63 ^ __builtin_clzll(x);
+#else
     unsigned int n = 63;
     while ((x & (1ULL << n)) == 0) {
         n--;
     }
     return n;
-}
\ No newline at end of file
+#endif
+}
+
+// Clear the lowest set bit (blsr with -mbmi)
+constexpr uint64_t clearLsb(uint64_t x) { return x & (x - 1); }
+
+constexpr int popcountSoftware(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+}
+
+// Parallel bit extract: gathers the bits of x selected by mask into the low bits
+constexpr uint64_t pextSoftware(uint64_t x, uint64_t mask) {
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (x & mask & -mask) result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+#if defined(BITS_X86_DISPATCH)
+// Inline asm rather than intrinsics so the instructions can be emitted without -mpopcnt / -mbmi2
+inline int popcountHardware(uint64_t x) {
+    uint64_t result;
+    asm("popcntq %1, %0" : "=r"(result) : "rm"(x) : "cc");
+    return static_cast<int>(result);
+}
+
+inline uint64_t pextHardware(uint64_t x, uint64_t mask) {
+    uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(x), "rm"(mask));
+    return result;
+}
+#endif
+
+// Number of set bits
+constexpr int popcount(uint64_t x) {
+#if defined(__POPCNT__)
+    return __builtin_popcountll(x);
+#elif defined(BITS_X86_DISPATCH)
+    if (BITS_CONSTANT_EVALUATED()) return popcountSoftware(x);
+    return CPU_FEATURES.popcnt ? popcountHardware(x) : popcountSoftware(x);
+#else
+    return popcountSoftware(x);
+#endif
+}
+
+constexpr uint64_t pext(uint64_t x, uint64_t mask) {
+#if defined(__BMI2__)
+    if (BITS_CONSTANT_EVALUATED()) return pextSoftware(x, mask);
+    return __builtin_ia32_pext_di(x, mask);
+#elif defined(BITS_X86_DISPATCH)
+    if (BITS_CONSTANT_EVALUATED()) return pextSoftware(x, mask);
+    return CPU_FEATURES.bmi2 ? pextHardware(x, mask) : pextSoftware(x, mask);
+#else
+    return pextSoftware(x, mask);
+#endif
+}
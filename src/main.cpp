@@ -1,17 +1,49 @@
+#include <iostream>
+#include <string>
+
 #include "AI/AI.h"
 #include "Chess/ChessBoard.h"
 #include "Config/Config.h"
+#include "Tools/Bench.h"
+#include "Tools/Perft.h"
+#include "Tools/SelfTest.h"
+#include "Tools/TablebaseGen.h"
 #include "UI/ConsoleDisplay.h"
 #include "UI/GDisplay.h"
 #include "UI/IDisplay.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        return runBench(argc - 2, argv + 2);
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "perft") {
+        return runPerft(argc - 2, argv + 2);
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "tbgen") {
+        return runTablebaseGen(argc - 2, argv + 2);
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "test") {
+        return runSelfTest(argc - 2, argv + 2);
+    }
+
     Config& config = Config::getInstance();
 
-    AI ai(config.difficulty, config.timeLimit);
+    AI ai(config.difficulty, config.timeLimit, config.hashSize, config.threads,
+          searchModeFromString(config.searchMode));
+    ai.setPruning({config.nullMove, config.lateMoveReductions, config.futilityPruning, config.reverseFutility});
+    ai.setPonder(config.ponder);
+    if (!config.book.empty() && !ai.loadBook(config.book)) {
+        std::cerr << "Error: Could not load opening book " << config.book << ", playing without it\n";
+    }
+    if (!config.tablebaseDir.empty() && ai.loadTablebases(config.tablebaseDir) == 0) {
+        std::cerr << "Error: No tablebases found in " << config.tablebaseDir << ", run `ChessGame tbgen "
+                  << config.tablebaseDir << "` to build them\n";
+    }
     IDisplay* display = nullptr;
     ChessBoard board;
-    board.initializeZobristTable();
 
     if (config.useGui) {
         display = new GDisplay(&ai);